@@ -3,15 +3,80 @@
  *  @author Patrycja Stępień
 */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "stack.h"
 #include "read_input.h"
+#include "instructions.h"
+#include "poly_alloc.h"
+#include "program.h"
+#include "output.h"
 
 /**
- * Tworzy stos, wczytuje polecenia ze standardowego wejścia,
+ * Wypisuje sposób użycia programu.
+ * @param[in] name : nazwa programu
+ */
+static void PrintUsage(char const* name) {
+    fprintf(stderr, "Usage: %s [-i] [-f file [-c cache]]\n", name);
+}
+
+/**
+ * Tworzy stos, wczytuje polecenia ze standardowego wejścia lub z pliku,
  * wykonuje żądane polecania, usuwa stos.
+ * Opcja -i włącza tryb unikalnych wielomianów (PolyIntern).
+ * Opcja -f plik wczytuje polecenia z pliku zamiast ze standardowego wejścia.
+ * Opcja -c plik, podana razem z -f, wykonuje skrypt skompilowany do programu
+ * i zapisuje program w zadanym pliku, żeby kolejne uruchomienia dla tej
+ * samej wersji skryptu nie musiały go parsować.
+ * @param[in] argc : liczba argumentów programu
+ * @param[in] argv : argumenty programu
+ * @return kod wyjścia programu
  */
-int main() {
+int main(int argc, char* argv[]) {
+    char const* path = NULL;
+    char const* cachePath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0) {
+            PolySetInterning(true);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cachePath = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (cachePath != NULL && path == NULL) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Zbuforowane wyniki trafiają na wyjście także przy wyjściu przez exit.
+    atexit(OutputFlush);
     Stack stack = StackCreate();
-    ReadInput(&stack);
+    int exitCode = 0;
+    if (path == NULL) {
+        ReadInput(&stack);
+    } else if (cachePath != NULL) {
+        Program program;
+        if (ProgramLoadCached(&program, path, cachePath)) {
+            ProgramOptimize(&program);
+            ProgramRun(&program, &stack);
+            ProgramDestroy(&program);
+        } else {
+            exitCode = 1;
+        }
+    } else if (!ReadInputFile(&stack, path)) {
+        exitCode = 1;
+    }
+    if (exitCode != 0) {
+        OutputFlush();
+        fprintf(stderr, "Cannot open %s\n", path);
+    }
     StackDestroy(&stack);
+    EvalCacheDestroy();
+    PolyAllocRelease();
+    return exitCode;
 }
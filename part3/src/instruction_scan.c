@@ -3,22 +3,15 @@
  *  @author Patrycja Stępień
 */
 
-/**
- * Makro potrzebne do prawidłowego wykonywania funkcji getline.
- */
-#define _GNU_SOURCE
-
 #include <ctype.h>
-#include <errno.h>
-#include <inttypes.h>
+#include <limits.h>
 #include <stdbool.h>
-#include <stdlib.h>
-#include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include "stack.h"
 #include "instruction_scan.h"
 #include "instructions.h"
-#include "tools.h"
+#include "output.h"
 
 /**
  * Spacja, używane do podziału instrukcji na polecenie i parametr.
@@ -31,246 +24,284 @@
 #define DECIMAL_BASE 10
 
 /**
- * Długość polecenia 'AT', potrzebne do wycinania napisu.
+ * Rozmiar tablicy nazw poleceń.
  */
-#define AT_LENGTH 2
+#define COMMAND_HASH_SIZE 64
 
 /**
- * Długość polecenia 'DEG_BY', potrzebne do wycinania napisu.
+ * Indeks nazwy polecenia w tablicy nazw, wyznaczony z długości nazwy oraz
+ * jej pierwszego i ostatniego znaku. Dla nazw wszystkich poleceń indeksy są
+ * różne, więc słowo trzeba porównać tylko z jedną nazwą.
  */
-#define DEG_BY_LENGTH 6
+#define COMMAND_HASH(length, first, last) \
+    (((length) * 7 + (unsigned char) (first) + 2 * (unsigned char) (last)) & \
+     (COMMAND_HASH_SIZE - 1))
 
 /**
- * Długość polecenia 'COMPOSE', potrzebne do wycinania napisu.
+ * Nazwa polecenia w tablicy nazw.
  */
-#define COMPOSE_LENGTH 7
+typedef struct CommandName {
+    char const* name; ///< nazwa polecenia
+    size_t length; ///< długość nazwy, 0 dla pustego miejsca
+    CommandId id; ///< polecenie
+} CommandName;
 
 /**
- * Wykonuje instrukcje bez parametrów.
- * @param[in, out] stack : stos
- * @param[in] lineNumber : numer wczytanego wiersza
- * @param[in] instruction : napis zawierający instrukcję do wykonania
- * @param[in] lineSize : rozmiar wiersza z instrukcją
+ * Wpis tablicy nazw dla polecenia o zadanej nazwie oraz jej pierwszym
+ * i ostatnim znaku.
  */
-static void ExecuteInstruction(Stack* stack, int lineNumber, char* instruction, size_t lineSize) {
-    if (instruction[lineSize - 1] != '\n') {
-        instruction[lineSize] = '\n';
-    }
+#define COMMAND(text, first, last, command) \
+    [COMMAND_HASH(sizeof(text) - 1, first, last)] = {text, sizeof(text) - 1, command}
 
-    if (memcmp(instruction, "ADD\n", lineSize + 1) == 0) {
-        ADD(stack, lineNumber);
-    } else if (memcmp(instruction, "ZERO\n", lineSize + 1) == 0) {
-        ZERO(stack);
-    } else if (memcmp(instruction, "SUB\n", lineSize + 1) == 0) {
-        SUB(stack, lineNumber);
-    } else if (memcmp(instruction, "MUL\n", lineSize + 1) == 0) {
-        MUL(stack, lineNumber);
-    } else if (memcmp(instruction, "IS_COEFF\n", lineSize + 1) == 0) {
-        IS_COEFF(stack, lineNumber);
-    } else if (memcmp(instruction, "IS_ZERO\n", lineSize + 1) == 0) {
-        IS_ZERO(stack, lineNumber);
-    } else if (memcmp(instruction, "NEG\n", lineSize + 1) == 0) {
-        NEG(stack, lineNumber);
-    } else if (memcmp(instruction, "IS_EQ\n", lineSize + 1) == 0) {
-        IS_EQ(stack, lineNumber);
-    } else if (memcmp(instruction, "DEG\n", lineSize + 1) == 0) {
-        DEG(stack, lineNumber);
-    } else if (memcmp(instruction, "POP\n", lineSize + 1) == 0) {
-        POP(stack, lineNumber);
-    } else if (memcmp(instruction, "PRINT\n", lineSize + 1) == 0) {
-        PRINT(stack, lineNumber);
-    } else if (memcmp(instruction, "CLONE\n", lineSize + 1) == 0) {
-        CLONE(stack, lineNumber);
-    } else {
-        if (memcmp(instruction, "DEG_BY\n", lineSize + 1) == 0) {
-            fprintf(stderr, "ERROR %u DEG BY WRONG VARIABLE\n", lineNumber);
-        } else if (memcmp(instruction, "AT\n", lineSize + 1) == 0) {
-            fprintf(stderr, "ERROR %u AT WRONG VALUE\n", lineNumber);
-        } else if (memcmp(instruction, "COMPOSE\n", lineSize + 1) == 0) {
-            fprintf(stderr, "ERROR %u COMPOSE WRONG PARAMETER\n", lineNumber);
-        } else {
-            fprintf(stderr, "ERROR %u WRONG COMMAND\n", lineNumber);
-        }
-        return;
+/**
+ * Tablica nazw poleceń. Kompilator ostrzega o powtórzonym indeksie,
+ * gdyby dwie nazwy miały ten sam indeks.
+ */
+static const CommandName COMMANDS[COMMAND_HASH_SIZE] = {
+    COMMAND("ADD", 'A', 'D', CMD_ADD),
+    COMMAND("ZERO", 'Z', 'O', CMD_ZERO),
+    COMMAND("SUB", 'S', 'B', CMD_SUB),
+    COMMAND("MUL", 'M', 'L', CMD_MUL),
+    COMMAND("IS_COEFF", 'I', 'F', CMD_IS_COEFF),
+    COMMAND("IS_ZERO", 'I', 'O', CMD_IS_ZERO),
+    COMMAND("NEG", 'N', 'G', CMD_NEG),
+    COMMAND("IS_EQ", 'I', 'Q', CMD_IS_EQ),
+    COMMAND("DEG", 'D', 'G', CMD_DEG),
+    COMMAND("POP", 'P', 'P', CMD_POP),
+    COMMAND("PRINT", 'P', 'T', CMD_PRINT),
+    COMMAND("CLONE", 'C', 'E', CMD_CLONE),
+    COMMAND("SQR", 'S', 'R', CMD_SQR),
+    COMMAND("DEG_BY", 'D', 'Y', CMD_DEG_BY),
+    COMMAND("AT", 'A', 'T', CMD_AT),
+    COMMAND("COMPOSE", 'C', 'E', CMD_COMPOSE),
+    COMMAND("AT_MANY", 'A', 'Y', CMD_AT_MANY),
+    COMMAND("EVAL", 'E', 'L', CMD_EVAL)
+};
+
+/**
+ * Rozpoznaje polecenie po nazwie.
+ * @param[in] word : nazwa polecenia bez parametru i znaku nowej linii
+ * @param[in] size : długość nazwy
+ * @return rozpoznane polecenie albo CMD_UNKNOWN
+ */
+static CommandId FindCommand(char const* word, size_t size) {
+    if (size == 0) {
+        return CMD_UNKNOWN;
+    }
+    const CommandName* entry = &(COMMANDS[COMMAND_HASH(size, word[0], word[size - 1])]);
+    if (entry->length != size || memcmp(word, entry->name, size) != 0) {
+        return CMD_UNKNOWN;
     }
+    return entry->id;
 }
 
 /**
- * Sprawdza, czy wczytane polecenie jest poleceniem z parametrem sprawdzając,
- * czy zawiera ono spację.
- * @param[in] line : wiersz z poleceniem
- * @param[in] lineSize : rozmiar wiersza z poleceniem
- * @return czy wczytany wiersz zawiera spację
+ * Wykonuje polecenie ZERO.
+ * @param[in, out] stack : stos
+ * @param[in] lineNumber : numer wczytanego wiersza
  */
-static bool DoesLineContainSpace(char const* line, size_t lineSize) {
-    for (size_t i = 0; i < lineSize; i++) {
-        if (line[i] == SPACE) {
-            return true;
-        }
-    }
-    return false;
+static void ExecuteZero(Stack* stack, int lineNumber) {
+    (void) lineNumber;
+    ZERO(stack);
 }
 
 /**
- * Znajduje indeks spacji odddzielającej polecenie od parametru.
- * @param[in] line : wiersz z poleceniem
- * @param[in] lineSize : rozmiar wiersza z poleceniem
- * @return indeks pod którym występuje spacja
+ * Wykonuje polecenie IS_COEFF.
+ * @param[in] stack : stos
+ * @param[in] lineNumber : numer wczytanego wiersza
  */
-static size_t FindSpace(char const* line, size_t lineSize) {
-    for (size_t i = 0; i < lineSize; i++) {
-        if (line[i] == SPACE) {
-            return i;
-        }
-    }
-    return 0;
+static void ExecuteIsCoeff(Stack* stack, int lineNumber) {
+    IS_COEFF(stack, lineNumber);
 }
 
 /**
- * Sprawdza, czy po parametrze polecenia DEG_BY nie występują zbędne znaki.
- * @param[in] line : wiersz z poleceniem
+ * Wykonuje polecenie IS_ZERO.
+ * @param[in] stack : stos
+ * @param[in] lineNumber : numer wczytanego wiersza
+ */
+static void ExecuteIsZero(Stack* stack, int lineNumber) {
+    IS_ZERO(stack, lineNumber);
+}
+
+/**
+ * Polecenia bez parametrów, indeksowane identyfikatorem polecenia.
+ */
+static void (*const SIMPLE_COMMANDS[CMD_DEG_BY])(Stack* stack, int lineNumber) = {
+    [CMD_ADD] = ADD,
+    [CMD_ZERO] = ExecuteZero,
+    [CMD_SUB] = SUB,
+    [CMD_MUL] = MUL,
+    [CMD_IS_COEFF] = ExecuteIsCoeff,
+    [CMD_IS_ZERO] = ExecuteIsZero,
+    [CMD_NEG] = NEG,
+    [CMD_IS_EQ] = IS_EQ,
+    [CMD_DEG] = DEG,
+    [CMD_POP] = POP,
+    [CMD_PRINT] = PRINT,
+    [CMD_CLONE] = CLONE,
+    [CMD_SQR] = SQR
+};
+
+/**
+ * Komunikaty o błędnym parametrze poleceń z parametrem, indeksowane
+ * identyfikatorem polecenia pomniejszonym o CMD_DEG_BY.
+ */
+static char const* const WRONG_PARAMETER[CMD_UNKNOWN - CMD_DEG_BY] = {
+    [CMD_DEG_BY - CMD_DEG_BY] = "DEG BY WRONG VARIABLE",
+    [CMD_AT - CMD_DEG_BY] = "AT WRONG VALUE",
+    [CMD_COMPOSE - CMD_DEG_BY] = "COMPOSE WRONG PARAMETER",
+    [CMD_AT_MANY - CMD_DEG_BY] = "AT_MANY WRONG PARAMETER",
+    [CMD_EVAL - CMD_DEG_BY] = "EVAL WRONG PARAMETER"
+};
+
+/**
+ * Dekoduje polecenie bez parametru.
+ * @param[in] instruction : wiersz zawierający polecenie
  * @param[in] lineSize : rozmiar wiersza z poleceniem
- * @param[in] spaceInd : indeks spacji, początek sprawdzania
- * @return czy linia nie zawierała błędnych znaków
+ * @return zdekodowane polecenie
  */
-static bool IsCorrectDegByComposeEnd(char const* line, size_t lineSize, size_t spaceInd) {
-    // Po spacji powinny wystepowac tylko cyfry.
-    // Jedyna dozwolona sytuacja to znak nowej linii na końcu.
-    for (size_t i = spaceInd + 1; i < lineSize; i++) {
-        if (!isdigit(line[i])) {
-            if (!(i == lineSize - 1 && line[i] == '\n')) {
-                return false;
-            }
-        }
+static Command DecodeInstruction(char const* instruction, size_t lineSize) {
+    if (instruction[lineSize - 1] == '\n') {
+        lineSize--;
     }
-    return true;
+
+    // Polecenie wymagające parametru podane bez niego jest błędne.
+    CommandId id = FindCommand(instruction, lineSize);
+    return (Command) {.id = id, .correct = id < CMD_DEG_BY, .param = 0};
 }
 
 /**
- * Sprawdza, czy po parametrze polecenia AT nie występują zbędne znaki.
+ * Wczytuje parametr polecenia: liczbę zapisaną dziesiętnie, poprzedzoną
+ * spacją i opcjonalnie minusem, po której może wystąpić tylko znak nowej
+ * linii, i sprawdza, czy mieści się w zakresie.
  * @param[in] line : wiersz z poleceniem
  * @param[in] lineSize : rozmiar wiersza z poleceniem
- * @param[in] spaceInd : indeks spacji, początek sprawdzania
- * @return czy linia nie zawierała błędnych znaków
+ * @param[in] commandLength : długość nazwy polecenia
+ * @param[in] allowMinus : czy parametr może być ujemny
+ * @param[in] limit : największa dozwolona wartość bezwzględna parametru
+ * @param[out] negative : czy parametr jest ujemny
+ * @param[out] value : wartość bezwzględna parametru
+ * @return czy parametr jest poprawny
  */
-static bool IsCorrectAtEnd(char const* line, size_t lineSize, size_t spaceInd) {
-    // Po spacji powinny wystepowac tylko cyfry.
-    // Jedyna dozwolona sytuacja to znak nowej linii na końcu.
-    for (size_t i = spaceInd + 1; i < lineSize; i++) {
-        if (line[i] == '-') {
-            if (i != (spaceInd + 1)) {
-                return false;
-            }
-        } else {
-            if (!isdigit(line[i])) {
-                if (!(i == lineSize - 1 && line[i] == '\n')) {
-                    return false;
-                }
-            }
+static bool ParseParametr(char const* line, size_t lineSize, size_t commandLength,
+                          bool allowMinus, uint64_t limit, bool* negative,
+                          uint64_t* value) {
+    if (line[lineSize - 1] == '\n') {
+        lineSize--;
+    }
+    size_t i = commandLength + 1;
+    *negative = allowMinus && i < lineSize && line[i] == '-';
+    if (*negative) {
+        i++;
+    }
+    if (i == lineSize) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (; i < lineSize; i++) {
+        if (!isdigit((unsigned char) line[i])) {
+            return false;
+        }
+        uint64_t digit = (uint64_t) (line[i] - '0');
+        if (result > (limit - digit) / DECIMAL_BASE) {
+            return false;
         }
+        result = result * DECIMAL_BASE + digit;
     }
+    *value = result;
     return true;
 }
 
 /**
- * W przypadku wystąpienia błędu przy parsowaniu polecenia z argumentem
- * kończy działanie funkcji ExecuteInstructionWithParametr zwalniając
- * pamięć i wypisując komunikat o błędzie.
- * @param[in] message : komunikat o błędzie
- * @param[out] instruction : wiersz z wczytanym poleceniem
- * @param[out] parametr : długość wiersza z wczytanym poleceniem
- * @param[in] lineNumber : numer aktualnie wczytywanej linii
- */
-static void EndExecution(char const* message, char* instruction, char* parametr, int lineNumber) {
-    fprintf(stderr, message, lineNumber);
-    free(instruction);
-    free(parametr);
-}
-
-/**
- * Wykonuje polecenia z parametrem: AT, DEG_BY oraz COMPOSE.
- * @param[in, out] stack : stos
- * @param[in] lineNumber : numer aktualnie wczytywanej linii
- * @param[in, out] line : wiersz z wczytanym poleceniem
+ * Dekoduje polecenia z parametrem: AT, AT_MANY, DEG_BY, COMPOSE oraz EVAL.
+ * @param[in] line : wiersz z wczytanym poleceniem
  * @param[in] lineSize : długość wiersza z wczytanym poleceniem
+ * @param[in] space : pierwsza spacja w wierszu, kończąca nazwę polecenia
+ * @return zdekodowane polecenie
  */
-static void ExecuteInstructionWithParametr(Stack* stack, int lineNumber, char* line, size_t lineSize) {
-    char* instruction = Cut(line, 0, lineSize);
-    size_t spaceInd = FindSpace(line, lineSize);
-    char* parametr = Cut(line, spaceInd, lineSize);
+static Command DecodeInstructionWithParametr(char const* line, size_t lineSize,
+                                             char const* space) {
+    size_t commandLength = (size_t) (space - line);
+    Command command = {.id = FindCommand(line, commandLength), .correct = false, .param = 0};
+    if (command.id < CMD_DEG_BY) {
+        command.id = CMD_UNKNOWN;
+        return command;
+    }
 
-    if (memcmp(instruction, "DEG_BY", DEG_BY_LENGTH) == 0) {
-        if (line[DEG_BY_LENGTH] != SPACE) {
-            EndExecution("ERROR %u WRONG COMMAND\n", instruction, parametr, lineNumber);
-            return;
-        }
-        if (!isdigit(line[DEG_BY_LENGTH + 1]) || !IsCorrectDegByComposeEnd(line, lineSize, spaceInd)) {
-            EndExecution("ERROR %u DEG BY WRONG VARIABLE\n", instruction, parametr, lineNumber);
-            return;
-        }
-        char* pEnd;
-        unsigned long int x = strtoul(parametr, &pEnd, DECIMAL_BASE);
-        if (errno == ERANGE || (strcmp(pEnd, "\n") != 0 && strcmp(pEnd, "\0") != 0)) {
-            EndExecution("ERROR %u DEG BY WRONG VARIABLE\n", instruction, parametr, lineNumber);
-            return;
-        }
-        DEG_BY(stack, x, lineNumber);
-    } else if (memcmp(instruction, "COMPOSE", COMPOSE_LENGTH) == 0) {
-        if (line[COMPOSE_LENGTH] != SPACE) {
-            EndExecution("ERROR %u WRONG COMMAND\n", instruction, parametr, lineNumber);
-            return;
-        }
-        if (!isdigit(line[COMPOSE_LENGTH + 1]) || !IsCorrectDegByComposeEnd(line, lineSize, spaceInd)) {
-            EndExecution("ERROR %u COMPOSE WRONG PARAMETER\n", instruction, parametr, lineNumber);
-            return;
-        }
-        char* pEnd;
-        size_t x = strtoul(parametr, &pEnd, 10);
-        if (errno == ERANGE || (strcmp(pEnd, "\n") != 0 && strcmp(pEnd, "\0") != 0)) {
-            EndExecution("ERROR %u COMPOSE WRONG PARAMETER\n", instruction, parametr, lineNumber);
-            return;
-        }
-        COMPOSE(stack, lineNumber, x);
-    } else if (memcmp(instruction, "AT", AT_LENGTH) == 0) {
-        if (line[AT_LENGTH] != SPACE) {
-            EndExecution("ERROR %u WRONG COMMAND\n", instruction, parametr, lineNumber);
-            return;
-        }
-        if (!(isdigit(line[AT_LENGTH + 1]) || line[AT_LENGTH + 1] == '-') ||
-            !IsCorrectAtEnd(line, lineSize, spaceInd)) {
-            EndExecution("ERROR %u AT WRONG VALUE\n", instruction, parametr, lineNumber);
-            return;
-        }
-        char* pEnd;
-        long int x = strtol(parametr, &pEnd, DECIMAL_BASE);
-        if (errno == ERANGE || (strcmp(pEnd, "\n") != 0 && strcmp(pEnd, "\0") != 0)) {
-            EndExecution("ERROR %u AT WRONG VALUE\n", instruction, parametr, lineNumber);
-            return;
-        }
-        AT(stack, x, lineNumber);
-    } else {
-        EndExecution("ERROR %u WRONG COMMAND\n", instruction, parametr, lineNumber);
-        return;
+    bool negative;
+    uint64_t x;
+    switch (command.id) {
+        case CMD_UNKNOWN:
+            return command;
+        case CMD_DEG_BY:
+            command.correct = ParseParametr(line, lineSize, commandLength, false, ULONG_MAX,
+                                            &negative, &x);
+            break;
+        case CMD_AT:
+            command.correct = ParseParametr(line, lineSize, commandLength, true,
+                                            (uint64_t) LONG_MAX + 1, &negative, &x) &&
+                              (negative || x <= LONG_MAX);
+            // Wartość ujemna jest zapisana w kodzie uzupełnień do dwóch.
+            if (command.correct && negative) {
+                x = 0 - x;
+            }
+            break;
+        default:
+            command.correct = ParseParametr(line, lineSize, commandLength, false, SIZE_MAX,
+                                            &negative, &x);
+            break;
+    }
+    if (command.correct) {
+        command.param = x;
     }
+    return command;
+}
 
-    free(instruction);
-    free(parametr);
+Command InstructionDecode(char const* line, size_t lineSize) {
+    char const* space = memchr(line, SPACE, lineSize);
+    if (space != NULL) {
+        return DecodeInstructionWithParametr(line, lineSize, space);
+    }
+    return DecodeInstruction(line, lineSize);
 }
 
-void InstructionScan(Stack* stack, int lineNumber) {
-    char* instruction = NULL;
-    size_t length = 0;
-    size_t lineSize = 0;
+void InstructionError(CommandId id, int lineNumber) {
+    if (id >= CMD_DEG_BY && id < CMD_UNKNOWN) {
+        OutputError(lineNumber, WRONG_PARAMETER[id - CMD_DEG_BY]);
+    } else {
+        OutputError(lineNumber, "WRONG COMMAND");
+    }
+}
 
-    lineSize = getline(&instruction, &length, stdin);
-    if (instruction == NULL) {
-        exit(1);
+void InstructionExecute(Stack* stack, Command command, int lineNumber) {
+    if (!command.correct) {
+        InstructionError(command.id, lineNumber);
+        return;
     }
 
-    if (DoesLineContainSpace(instruction, lineSize)) {
-        ExecuteInstructionWithParametr(stack, lineNumber, instruction, lineSize);
-    } else {
-        ExecuteInstruction(stack, lineNumber, instruction, lineSize);
+    switch (command.id) {
+        case CMD_DEG_BY:
+            DEG_BY(stack, command.param, lineNumber);
+            break;
+        case CMD_AT:
+            AT(stack, (poly_coeff_t) command.param, lineNumber);
+            break;
+        case CMD_COMPOSE:
+            COMPOSE(stack, lineNumber, command.param);
+            break;
+        case CMD_AT_MANY:
+            AT_MANY(stack, lineNumber, command.param);
+            break;
+        case CMD_EVAL:
+            EVAL(stack, lineNumber, command.param);
+            break;
+        default:
+            SIMPLE_COMMANDS[command.id](stack, lineNumber);
+            break;
     }
-    free(instruction);
+}
+
+void InstructionScan(Stack* stack, char const* line, size_t lineSize, int lineNumber) {
+    InstructionExecute(stack, InstructionDecode(line, lineSize), lineNumber);
 }
@@ -5,14 +5,76 @@
 #ifndef INSTRUCTION_SCAN_H
 #define INSTRUCTION_SCAN_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "stack.h"
 
 /**
- * Wczytuje polecenie kalkulatora ze standardowego wejścia
- * i wstępnie rozpoznaje typ polecenia (z argumentem lub bez).
+ * Polecenia kalkulatora. Polecenia bez parametru są na początku,
+ * przed CMD_DEG_BY.
+ */
+typedef enum CommandId {
+    CMD_ADD, ///< ADD
+    CMD_ZERO, ///< ZERO
+    CMD_SUB, ///< SUB
+    CMD_MUL, ///< MUL
+    CMD_IS_COEFF, ///< IS_COEFF
+    CMD_IS_ZERO, ///< IS_ZERO
+    CMD_NEG, ///< NEG
+    CMD_IS_EQ, ///< IS_EQ
+    CMD_DEG, ///< DEG
+    CMD_POP, ///< POP
+    CMD_PRINT, ///< PRINT
+    CMD_CLONE, ///< CLONE
+    CMD_SQR, ///< SQR
+    CMD_DEG_BY, ///< DEG_BY
+    CMD_AT, ///< AT
+    CMD_COMPOSE, ///< COMPOSE
+    CMD_AT_MANY, ///< AT_MANY
+    CMD_EVAL, ///< EVAL
+    CMD_UNKNOWN ///< nieznane polecenie
+} CommandId;
+
+/**
+ * Zdekodowany wiersz z poleceniem.
+ */
+typedef struct Command {
+    CommandId id; ///< polecenie, CMD_UNKNOWN dla nieznanego polecenia
+    bool correct; ///< czy polecenie i jego parametr są poprawne
+    uint64_t param; ///< parametr; dla AT wartość w kodzie uzupełnień do dwóch
+} Command;
+
+/**
+ * Dekoduje wiersz z poleceniem, nie wykonując go.
+ * @param[in] line : wiersz z poleceniem, może nie kończyć się znakiem nowej linii
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @return zdekodowane polecenie
+ */
+Command InstructionDecode(char const* line, size_t lineSize);
+
+/**
+ * Wypisuje komunikat o błędnym poleceniu: o błędnym parametrze polecenia
+ * z parametrem albo o nieznanym poleceniu.
+ * @param[in] id : polecenie
+ * @param[in] lineNumber : numer wiersza z poleceniem
+ */
+void InstructionError(CommandId id, int lineNumber);
+
+/**
+ * Wykonuje zdekodowane polecenie albo wypisuje komunikat o błędzie.
+ * @param[in, out] stack : stos
+ * @param[in] command : zdekodowane polecenie
+ * @param[in] lineNumber : numer wiersza z poleceniem
+ */
+void InstructionExecute(Stack* stack, Command command, int lineNumber);
+
+/**
+ * Rozpoznaje typ polecenia kalkulatora (z argumentem lub bez) i je wykonuje.
  * @param[in, out] stack : stos
+ * @param[in] line : wiersz z poleceniem, może nie kończyć się znakiem nowej linii
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
  * @param[in] lineNumber : numer aktualnie wczytywanej linii
  */
-void InstructionScan(Stack* stack, int lineNumber);
+void InstructionScan(Stack* stack, char const* line, size_t lineSize, int lineNumber);
 
 #endif /* INSTRUCTION_SCAN_H */
\ No newline at end of file
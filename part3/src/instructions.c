@@ -5,50 +5,22 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include "stack.h"
 #include "poly.h"
-#include "tools.h"
 #include "instructions.h"
+#include "poly_tape.h"
+#include "output.h"
 
 void POP(Stack* stack, int lineNumber) {
     Pop(stack, lineNumber);
 }
 
-/**
- * Funkcja pomocnicza do PRINT, wypisuje wielomian na standardowe wyjście
- * w przypadku, gdy nie jest on współczynnikiem.
- * @param[in] p : wypisywany wielomian
- */
-static void PrintPoly(const Poly *p) {
-    for (size_t i = 0; i < p->size; i++) {
-        if (i == 0) {
-            printf("(");
-        } else {
-            printf("+(");
-        }
-        if (p->arr[i].p.arr == NULL) {
-            printf("%ld,%d)", p->arr[i].p.coeff, p->arr[i].exp);
-        } else {
-            PrintPoly(&(p->arr[i].p));
-            printf(",%d)", p->arr[i].exp);
-        }
-    }
-}
-
 void PRINT(Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
-
-    Poly* polyTop = Top(stack);
-    if (PolyIsCoeff(polyTop)) {
-        printf("%ld", polyTop->coeff);
-    } else {
-        PrintPoly(polyTop);
-    }
-    printf("\n");
+    OutputPoly(Top(stack));
 }
 
 /**
@@ -60,7 +32,7 @@ void PRINT(Stack* stack, int lineNumber) {
  */
 static void TwoArgOperation (Stack* stack, int lineNumber, enum TwoArgOp operation) {
     if (IsStackSingle(stack) || IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
 
@@ -72,18 +44,23 @@ static void TwoArgOperation (Stack* stack, int lineNumber, enum TwoArgOp operati
     Poly PolyRes;
     switch (operation) {
         case add:
-            PolyRes = PolyAdd(PolyA, PolyB);
+            // Oba argumenty są zdejmowane ze stosu, więc możemy je przejąć.
+            PolyRes = *PolyA;
+            *PolyA = PolyZero();
+            PolyAddTo(&PolyRes, PolyB);
             break;
         case sub:
-            PolyRes = PolySub(PolyA, PolyB);
+            // Odjemnik też jest zdejmowany ze stosu, więc zamiast tworzyć
+            // wielomian przeciwny negujemy go w miejscu.
+            PolyRes = *PolyA;
+            *PolyA = PolyZero();
+            PolySubTo(&PolyRes, PolyB);
             break;
         case mul:
             PolyRes = PolyMul(PolyA, PolyB);
             break;
     }
-    POP(stack, lineNumber);
-    POP(stack, lineNumber);
-    Push(stack, PolyRes);
+    ReplaceTopTwo(stack, PolyRes);
 }
 
 void ADD(Stack* stack, int lineNumber) {
@@ -100,7 +77,7 @@ void MUL(Stack* stack, int lineNumber) {
 
 void IS_EQ(Stack* stack, int lineNumber) {
     if (IsStackSingle(stack) || IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly* PolyA = Top(stack);
@@ -109,50 +86,81 @@ void IS_EQ(Stack* stack, int lineNumber) {
     (stack->pointer)++;
 
     if (PolyIsEq(PolyA, PolyB)) {
-        printf("1\n");
+        OutputLine(1);
     } else {
-        printf("0\n");
+        OutputLine(0);
     }
 }
 
 void DEG(Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly* PolyTop = Top(stack);
-    printf("%d\n", PolyDeg(PolyTop));
+    OutputLine(PolyDeg(PolyTop));
 }
 
 void DEG_BY(Stack* stack, size_t idx, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %u STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly* PolyTop = Top(stack);
-    printf("%d\n", PolyDegBy(PolyTop, idx));
+    OutputLine(PolyDegBy(PolyTop, idx));
 }
 
 void AT(Stack* stack, poly_coeff_t x, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly* PolyTop = Top(stack);
-    Poly PolyRes = PolyAt(PolyTop, x);
+    ReplaceTop(stack, PolyAt(PolyTop, x));
+}
+
+void AT_MANY(Stack* stack, int lineNumber, size_t k) {
+    // Oprócz k punktów na stosie musi leżeć wielomian.
+    if (IsStackEmpty(stack) || stack->pointer - 1 < k) {
+        OutputError(lineNumber, "STACK UNDERFLOW");
+        return;
+    }
+
+    // Punkty leżą pod wierzchołkiem, najgłębszy z nich jest pierwszy.
+    size_t first = stack->pointer - 1 - k;
+    Poly* points = &(stack->arr[first]);
+    for (size_t i = 0; i < k; i++) {
+        if (!PolyIsCoeff(&(points[i]))) {
+            OutputError(lineNumber, "AT_MANY WRONG VALUE");
+            return;
+        }
+    }
+
+    poly_coeff_t* xs = malloc((k > 0 ? k : 1) * sizeof(poly_coeff_t));
+    Poly* values = malloc((k > 0 ? k : 1) * sizeof(Poly));
+    if (xs == NULL || values == NULL) {
+        exit(1);
+    }
+    for (size_t i = 0; i < k; i++) {
+        xs[i] = points[i].coeff;
+    }
+    PolyAtMany(Top(stack), k, xs, values);
     POP(stack, lineNumber);
-    Push(stack, PolyRes);
+    for (size_t i = 0; i < k; i++) {
+        // Punkty są współczynnikami, więc nie trzeba ich usuwać.
+        stack->arr[first + i] = values[i];
+    }
+    free(xs);
+    free(values);
 }
 
 void NEG(Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly* polyTop = Top(stack);
-    Poly polyRes = PolyNeg(polyTop);
-    POP(stack, lineNumber);
-    Push(stack, polyRes);
+    ReplaceTop(stack, PolyNeg(polyTop));
 }
 
 void ZERO(Stack* stack) {
@@ -162,39 +170,91 @@ void ZERO(Stack* stack) {
 
 void IS_COEFF(const Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
 
     if (PolyIsCoeff(Top(stack))) {
-        printf("1\n");
+        OutputLine(1);
     } else {
-        printf("0\n");
+        OutputLine(0);
     }
 }
 
 void IS_ZERO(const Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
 
     if (PolyIsZero(Top(stack))) {
-        printf("1\n");
+        OutputLine(1);
     } else {
-        printf("0\n");
+        OutputLine(0);
     }
 }
 
 void CLONE(Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     Poly PolyTop = PolyClone(Top(stack));
     Push(stack, PolyTop);
 }
 
+void SQR(Stack* stack, int lineNumber) {
+    if (IsStackEmpty(stack)) {
+        OutputError(lineNumber, "STACK UNDERFLOW");
+        return;
+    }
+    Poly* polyTop = Top(stack);
+    ReplaceTop(stack, PolySqr(polyTop));
+}
+
+bool CLONE_MUL(Stack* stack) {
+    if (IsStackEmpty(stack)) {
+        return false;
+    }
+    // Na niepustym stosie SQR nie zgłasza błędu, więc numer wiersza
+    // nie jest używany.
+    SQR(stack, 0);
+    return true;
+}
+
+bool NEG_ADD(Stack* stack) {
+    if (IsStackSingle(stack) || IsStackEmpty(stack)) {
+        return false;
+    }
+    // Odjemnik zdejmujemy ze stosu, a odjemną przejmujemy z niego, więc
+    // oba wielomiany można zmieniać w miejscu.
+    Poly subtrahend = Take(stack);
+    Poly* polyTop = Top(stack);
+    Poly difference = *polyTop;
+    *polyTop = PolyZero();
+    PolySubTo(&difference, &subtrahend);
+    ReplaceTop(stack, difference);
+    return true;
+}
+
+bool MUL_ADD(Stack* stack) {
+    if (!IsStackOfSizeAtLeastN(stack, 3)) {
+        return false;
+    }
+    Poly factor = Take(stack);
+    Poly* polyA = Top(stack);
+    (stack->pointer)--;
+    Poly* polyB = Top(stack);
+    (stack->pointer)++;
+
+    Poly sum = *polyB;
+    *polyB = PolyZero();
+    PolyAddMulTo(&sum, &factor, polyA);
+    PolyDestroy(&factor);
+    ReplaceTopTwo(stack, sum);
+    return true;
+}
+
 /**
  * Usuwa z pamięci tablicę wielomianów oraz jej elementy.
  * @param[out] polyArr : tablica wielomianów
@@ -220,31 +280,87 @@ static Poly* CreateComposeArgumentsArray(Stack* stack, size_t k) {
         exit(1);
     }
     for (size_t i = 0; i < k; i++) {
-        q[k - 1 - i] = *(Top(stack));
-        (stack->pointer)--;
+        q[k - 1 - i] = Take(stack);
     }
     return q;
 }
 
 void COMPOSE(Stack* stack, int lineNumber, size_t k) {
-    if (!IsStackOfSizeAtLeastN(stack, 1)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
-        return;
-    }
-    Poly mainPoly = *(Top(stack));
-    (stack->pointer)--;
-
-    if (!IsStackOfSizeAtLeastN(stack, k)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
-        // Zakładamy, że nie zdjęliśmy górnego wielomianu ze stosu.
-        (stack->pointer)++;
+    if (IsStackEmpty(stack) || stack->pointer - 1 < k) {
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
 
+    Poly mainPoly = Take(stack);
     Poly* q = CreateComposeArgumentsArray(stack, k);
     Poly result = PolyCompose(&mainPoly, k, q);
 
     PolyDestroy(&mainPoly);
     DestroyPolyArr(q, k);
     Push(stack, result);
+}
+
+/**
+ * Taśma ostatnio obliczanego poleceniem EVAL wielomianu. Przechowujemy
+ * kopię tego wielomianu, więc jego tablica jednomianów nie zostanie
+ * zwolniona ani użyta ponownie, dopóki taśma jest w pamięci.
+ */
+typedef struct EvalCache {
+    Poly poly; ///< skompilowany wielomian
+    PolyTape tape; ///< taśma
+} EvalCache;
+
+/**
+ * Taśma zapamiętana przez polecenie EVAL.
+ */
+static EvalCache evalCache = {.poly = {.coeff = 0, .arr = NULL}};
+
+/**
+ * Zwraca taśmę dla wielomianu, kompilując go tylko wtedy, gdy nie jest
+ * on tym samym wielomianem co przy poprzednim wywołaniu.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return taśma obliczająca wartość @p p
+ */
+static PolyTape* EvalTape(const Poly* p) {
+    if (evalCache.poly.arr != p->arr) {
+        EvalCacheDestroy();
+        evalCache.poly = PolyClone(p);
+        evalCache.tape = PolyCompileEval(p);
+    }
+    return &(evalCache.tape);
+}
+
+void EvalCacheDestroy(void) {
+    if (evalCache.poly.arr != NULL) {
+        PolyDestroy(&(evalCache.poly));
+        PolyTapeDestroy(&(evalCache.tape));
+    }
+}
+
+void EVAL(Stack* stack, int lineNumber, size_t k) {
+    // Błędy i argumenty niebędące współczynnikami obsługuje COMPOSE.
+    if (IsStackEmpty(stack) || stack->pointer - 1 < k) {
+        COMPOSE(stack, lineNumber, k);
+        return;
+    }
+    size_t first = stack->pointer - 1 - k;
+    for (size_t i = 0; i < k; i++) {
+        if (!PolyIsCoeff(&(stack->arr[first + i]))) {
+            COMPOSE(stack, lineNumber, k);
+            return;
+        }
+    }
+
+    Poly mainPoly = Take(stack);
+    poly_coeff_t result = mainPoly.coeff;
+    if (!PolyIsCoeff(&mainPoly)) {
+        // Zdjęcie wielomianu mogło przenieść tablicę stosu.
+        result = PolyTapeEval(EvalTape(&mainPoly), k, &(stack->arr[first]));
+    }
+    PolyDestroy(&mainPoly);
+    // Argumenty są współczynnikami, więc nie trzeba ich usuwać.
+    for (size_t i = 0; i < k; i++) {
+        Take(stack);
+    }
+    Push(stack, PolyFromCoeff(result));
 }
\ No newline at end of file
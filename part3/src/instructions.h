@@ -89,6 +89,17 @@ void DEG_BY(Stack* stack, size_t idx, int lineNumber);
  */
 void AT(Stack* stack, poly_coeff_t x, int lineNumber);
 
+/**
+ * Wylicza wartości wielomianu z wierzchołka stosu w k punktach,
+ * którymi są współczynniki leżące na stosie pod nim.
+ * Usuwa wielomian z wierzchołka, a każdy z punktów zastępuje
+ * wartością wielomianu w tym punkcie.
+ * @param[in, out] stack : stos
+ * @param[in] lineNumber : numer wykonywanego wiersza
+ * @param[in] k : liczba punktów
+ */
+void AT_MANY(Stack* stack, int lineNumber, size_t k);
+
 /**
  * Neguje wielomian na wierzchołku stosu.
  * @param[in, out] stack : stos
@@ -125,6 +136,41 @@ void IS_ZERO(const Stack* stack, int lineNumber);
  */
 void CLONE(Stack* stack, int lineNumber);
 
+/**
+ * Podnosi do kwadratu wielomian z wierzchołka stosu.
+ * @param[in, out] stack : stos
+ * @param[in] lineNumber : numer wykonywanego wiersza
+ */
+void SQR(Stack* stack, int lineNumber);
+
+/**
+ * Wykonuje polecenia CLONE i MUL naraz: zastępuje wielomian z wierzchołka
+ * stosu jego kwadratem, bez wstawiania kopii na stos.
+ * @param[in, out] stack : stos
+ * @return czy stos był niepusty; w przeciwnym razie nic nie jest wykonywane
+ */
+bool CLONE_MUL(Stack* stack);
+
+/**
+ * Wykonuje polecenia NEG i ADD naraz: odejmuje wielomian z wierzchołka
+ * od wielomianu pod wierzchołkiem, usuwa je i wstawia na wierzchołek stosu
+ * różnicę, bez tworzenia wielomianu przeciwnego.
+ * @param[in, out] stack : stos
+ * @return czy stos miał co najmniej dwa wielomiany; w przeciwnym razie
+ * nic nie jest wykonywane
+ */
+bool NEG_ADD(Stack* stack);
+
+/**
+ * Wykonuje polecenia MUL i ADD naraz: dodaje iloczyn dwóch wielomianów
+ * z wierzchu stosu do trzeciego wielomianu, usuwa je i wstawia na
+ * wierzchołek stosu wynik.
+ * @param[in, out] stack : stos
+ * @return czy stos miał co najmniej trzy wielomiany; w przeciwnym razie
+ * nic nie jest wykonywane
+ */
+bool MUL_ADD(Stack* stack);
+
 /**
  * Pod l zmiennych wielomianu p ze szczytu stosu, oznaczonych jako @f$x_0@f$, @f$x_1@f$, ..., @f$x_{l-1}@f$,
  * podstawia k kolejnych wielomianów ze stosu,
@@ -138,4 +184,22 @@ void CLONE(Stack* stack, int lineNumber);
  */
 void COMPOSE (Stack* stack, int lineNumber, size_t k);
 
+/**
+ * Oblicza wartość wielomianu z wierzchołka stosu, podstawiając pod zmienne
+ * @f$x_0, \ldots, x_{k-1}@f$ współczynniki leżące na stosie pod nim,
+ * tak jak COMPOSE. Wielomian kompilowany jest do taśmy (PolyCompileEval),
+ * a taśma ostatniego wielomianu jest zapamiętywana, więc kolejne obliczenia
+ * tego samego wielomianu nie alokują pamięci. Jeśli któryś z argumentów
+ * nie jest współczynnikiem, polecenie wykonywane jest jako COMPOSE.
+ * @param[in, out] stack : stos
+ * @param[in] lineNumber : numer wykonywanego wiersza
+ * @param[in] k : liczba wartości podstawianych pod zmienne
+ */
+void EVAL(Stack* stack, int lineNumber, size_t k);
+
+/**
+ * Zwalnia taśmę zapamiętaną przez polecenie EVAL.
+ */
+void EvalCacheDestroy(void);
+
 #endif /* INSTRUCTIONS_H */
\ No newline at end of file
@@ -0,0 +1,283 @@
+/** @file
+ *  Implementacja obliczania wartości wielomianu jednej zmiennej
+ *  w wielu punktach za pomocą drzewa iloczynów i drzewa reszt.
+ *  @author Patrycja Stępień
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ntt.h"
+#include "multipoint.h"
+
+/**
+ * Liczba punktów w liściu drzewa iloczynów. W liściach wartości liczone są
+ * schematem Hornera z reszty stopnia mniejszego niż liczba punktów liścia.
+ */
+#define MULTIPOINT_LEAF_POINTS 128
+
+/**
+ * Długość krótszego czynnika, od której mnożenie wykonywane jest przez NTT.
+ */
+#define MULTIPOINT_NTT_MIN_LENGTH 256
+
+/**
+ * Drzewo iloczynów dla ciągu punktów. Węzeł @f$i@f$ ma dzieci
+ * @f$2i + 1@f$ i @f$2i + 2@f$, a jego wielomian to unormowany iloczyn
+ * @f$\prod (x - x_j)@f$ po punktach jego przedziału.
+ */
+typedef struct ProductTree {
+    uint64_t** nodes; ///< współczynniki wielomianów węzłów
+    size_t* degrees; ///< stopnie wielomianów węzłów
+    size_t nodesCount; ///< liczba miejsc na węzły
+} ProductTree;
+
+/**
+ * Alokuje tablicę liczb 64-bitowych. Kończy program kodem 1, jeśli zabraknie
+ * pamięci.
+ * @param[in] count : liczba elementów
+ * @return zaalokowana tablica
+ */
+static uint64_t* AllocU64(size_t count) {
+    uint64_t* arr = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (arr == NULL) {
+        exit(1);
+    }
+    return arr;
+}
+
+/**
+ * Mnoży dwa gęste wielomiany modulo @f$2^{64}@f$: krótkie szkolnie,
+ * długie za pomocą NttMul.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] lenA : liczba współczynników pierwszego czynnika, dodatnia
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] lenB : liczba współczynników drugiego czynnika, dodatnia
+ * @param[out] result : tablica na @f$lenA + lenB - 1@f$ współczynników,
+ *                      rozłączna z czynnikami
+ */
+static void MulU64(const uint64_t* a, size_t lenA, const uint64_t* b,
+                   size_t lenB, uint64_t* result) {
+    if (lenA >= MULTIPOINT_NTT_MIN_LENGTH && lenB >= MULTIPOINT_NTT_MIN_LENGTH) {
+        NttMul(a, lenA, b, lenB, result);
+        return;
+    }
+
+    memset(result, 0, (lenA + lenB - 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < lenA; i++) {
+        for (size_t j = 0; j < lenB; j++) {
+            result[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+/**
+ * Liczy odwrotność szeregu potęgowego o wyrazie wolnym 1 modulo
+ * @f$x^{len}@f$ iteracją Newtona @f$g \leftarrow g (2 - f g)@f$, która
+ * podwaja liczbę poprawnych współczynników w każdym kroku.
+ * @param[in] f : współczynniki szeregu, @f$f_0 = 1@f$
+ * @param[in] lenF : liczba współczynników szeregu
+ * @param[in] len : liczba szukanych współczynników odwrotności
+ * @param[out] inverse : tablica na @p len współczynników odwrotności
+ */
+static void SeriesInverse(const uint64_t* f, size_t lenF, size_t len,
+                          uint64_t* inverse) {
+    uint64_t* product = AllocU64(2 * len);
+    uint64_t* error = AllocU64(len);
+    inverse[0] = 1;
+
+    for (size_t known = 1; known < len;) {
+        size_t next = 2 * known < len ? 2 * known : len;
+        size_t usedF = lenF < next ? lenF : next;
+
+        // error = 2 - f * g mod x^next
+        MulU64(f, usedF, inverse, known, product);
+        size_t productLen = usedF + known - 1;
+        for (size_t i = 0; i < next; i++) {
+            error[i] = i < productLen ? -product[i] : 0;
+        }
+        error[0] += 2;
+
+        MulU64(inverse, known, error, next, product);
+        memcpy(inverse, product, next * sizeof(uint64_t));
+        known = next;
+    }
+
+    free(product);
+    free(error);
+}
+
+/**
+ * Liczy resztę z dzielenia wielomianu przez wielomian unormowany.
+ * Iloraz wyznaczany jest z odwrotności odwróconego dzielnika, a reszta
+ * jako @f$a - q m@f$ obcięte do współczynników niższych niż stopień
+ * dzielnika.
+ * @param[in] a : współczynniki dzielnej
+ * @param[in] lenA : liczba współczynników dzielnej
+ * @param[in] m : współczynniki dzielnika, @f$m_{deg} = 1@f$
+ * @param[in] deg : stopień dzielnika, dodatni
+ * @param[out] rem : tablica na @p deg współczynników reszty
+ */
+static void RemMonic(const uint64_t* a, size_t lenA, const uint64_t* m,
+                     size_t deg, uint64_t* rem) {
+    if (lenA <= deg) {
+        memcpy(rem, a, lenA * sizeof(uint64_t));
+        memset(rem + lenA, 0, (deg - lenA) * sizeof(uint64_t));
+        return;
+    }
+
+    size_t quotLen = lenA - deg;
+    size_t revMLen = deg + 1 < quotLen ? deg + 1 : quotLen;
+    uint64_t* revM = AllocU64(revMLen);
+    uint64_t* revA = AllocU64(quotLen);
+    for (size_t i = 0; i < revMLen; i++) {
+        revM[i] = m[deg - i];
+    }
+    for (size_t i = 0; i < quotLen; i++) {
+        revA[i] = a[lenA - 1 - i];
+    }
+
+    uint64_t* inverse = AllocU64(quotLen);
+    SeriesInverse(revM, revMLen, quotLen, inverse);
+    free(revM);
+
+    uint64_t* product = AllocU64(2 * quotLen + deg);
+    MulU64(revA, quotLen, inverse, quotLen, product);
+    free(revA);
+    free(inverse);
+
+    uint64_t* quot = AllocU64(quotLen);
+    for (size_t i = 0; i < quotLen; i++) {
+        quot[i] = product[quotLen - 1 - i];
+    }
+
+    // Wyższe współczynniki a - q * m są zerowe, potrzebujemy tylko niższych.
+    size_t usedQuot = quotLen < deg ? quotLen : deg;
+    MulU64(quot, usedQuot, m, deg, product);
+    size_t productLen = usedQuot + deg - 1;
+    for (size_t i = 0; i < deg; i++) {
+        rem[i] = a[i] - (i < productLen ? product[i] : 0);
+    }
+
+    free(product);
+    free(quot);
+}
+
+/**
+ * Buduje węzeł drzewa iloczynów i jego poddrzewa.
+ * @param[in, out] tree : drzewo iloczynów
+ * @param[in] node : indeks węzła
+ * @param[in] points : punkty
+ * @param[in] lo : początek przedziału punktów węzła
+ * @param[in] hi : koniec przedziału punktów węzła (bez niego)
+ */
+static void BuildNode(ProductTree* tree, size_t node, const uint64_t* points,
+                      size_t lo, size_t hi) {
+    size_t deg = hi - lo;
+    uint64_t* poly = AllocU64(deg + 1);
+    tree->degrees[node] = deg;
+    tree->nodes[node] = poly;
+
+    if (deg <= MULTIPOINT_LEAF_POINTS) {
+        poly[0] = 1;
+        for (size_t i = 0; i < deg; i++) {
+            // poly = poly * (x - points[lo + i])
+            poly[i + 1] = poly[i];
+            for (size_t j = i; j > 0; j--) {
+                poly[j] = poly[j - 1] - poly[j] * points[lo + i];
+            }
+            poly[0] = -poly[0] * points[lo + i];
+        }
+        return;
+    }
+
+    size_t mid = lo + deg / 2;
+    BuildNode(tree, 2 * node + 1, points, lo, mid);
+    BuildNode(tree, 2 * node + 2, points, mid, hi);
+    MulU64(tree->nodes[2 * node + 1], mid - lo + 1,
+           tree->nodes[2 * node + 2], hi - mid + 1, poly);
+}
+
+/**
+ * Schodzi drzewem reszt: redukuje wielomian modulo wielomiany dzieci węzła,
+ * a w liściach oblicza wartości schematem Hornera.
+ * @param[in] tree : drzewo iloczynów
+ * @param[in] node : indeks węzła
+ * @param[in] rem : reszta modulo wielomian węzła
+ * @param[in] lenRem : liczba współczynników reszty
+ * @param[in] points : punkty
+ * @param[in] lo : początek przedziału punktów węzła
+ * @param[in] hi : koniec przedziału punktów węzła (bez niego)
+ * @param[out] values : wartości wielomianu w punktach
+ */
+static void DescendNode(const ProductTree* tree, size_t node,
+                        const uint64_t* rem, size_t lenRem,
+                        const uint64_t* points, size_t lo, size_t hi,
+                        uint64_t* values) {
+    if (hi - lo <= MULTIPOINT_LEAF_POINTS) {
+        for (size_t i = lo; i < hi; i++) {
+            uint64_t value = 0;
+            for (size_t j = lenRem; j > 0; j--) {
+                value = value * points[i] + rem[j - 1];
+            }
+            values[i] = value;
+        }
+        return;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    size_t children[2] = {2 * node + 1, 2 * node + 2};
+    size_t bounds[3] = {lo, mid, hi};
+    for (size_t c = 0; c < 2; c++) {
+        size_t deg = tree->degrees[children[c]];
+        uint64_t* childRem = AllocU64(deg);
+        RemMonic(rem, lenRem, tree->nodes[children[c]], deg, childRem);
+        DescendNode(tree, children[c], childRem, deg, points,
+                    bounds[c], bounds[c + 1], values);
+        free(childRem);
+    }
+}
+
+/**
+ * Oblicza wartości wielomianu w ciągu punktów, budując dla nich jedno
+ * drzewo iloczynów.
+ * @param[in] coeffs : współczynniki wielomianu
+ * @param[in] len : liczba współczynników
+ * @param[in] points : punkty
+ * @param[in] n : liczba punktów, dodatnia
+ * @param[out] values : tablica na @p n wartości
+ */
+static void EvalChunk(const uint64_t* coeffs, size_t len,
+                      const uint64_t* points, size_t n, uint64_t* values) {
+    size_t leaves = (n + MULTIPOINT_LEAF_POINTS - 1) / MULTIPOINT_LEAF_POINTS;
+    ProductTree tree;
+    tree.nodesCount = 4 * leaves;
+    tree.nodes = calloc(tree.nodesCount, sizeof(uint64_t*));
+    tree.degrees = calloc(tree.nodesCount, sizeof(size_t));
+    if (tree.nodes == NULL || tree.degrees == NULL) {
+        exit(1);
+    }
+
+    BuildNode(&tree, 0, points, 0, n);
+    uint64_t* rem = AllocU64(n);
+    RemMonic(coeffs, len, tree.nodes[0], n, rem);
+    DescendNode(&tree, 0, rem, len < n ? len : n, points, 0, n, values);
+    free(rem);
+
+    for (size_t i = 0; i < tree.nodesCount; i++) {
+        free(tree.nodes[i]);
+    }
+    free(tree.nodes);
+    free(tree.degrees);
+}
+
+void MultipointEval(const uint64_t* coeffs, size_t len,
+                    const uint64_t* points, size_t n, uint64_t* values) {
+    // Drzewo większe niż stopień wielomianu nie przyspiesza obliczeń,
+    // więc punkty dzielimy na grupy o wielkości zbliżonej do stopnia.
+    size_t chunk = len > MULTIPOINT_LEAF_POINTS ? len : MULTIPOINT_LEAF_POINTS;
+    for (size_t lo = 0; lo < n; lo += chunk) {
+        size_t count = n - lo < chunk ? n - lo : chunk;
+        EvalChunk(coeffs, len, points + lo, count, values + lo);
+    }
+}
@@ -0,0 +1,30 @@
+/** @file
+ *  Obliczanie wartości wielomianu jednej zmiennej w wielu punktach
+ *  za pomocą drzewa iloczynów i drzewa reszt.
+ *  @author Patrycja Stępień
+*/
+
+#ifndef MULTIPOINT_H
+#define MULTIPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Oblicza wartości gęstego wielomianu jednej zmiennej o współczynnikach
+ * modulo @f$2^{64}@f$ w @p n punktach. Buduje drzewo iloczynów
+ * @f$\prod (x - x_i)@f$ po poddrzewach punktów i schodzi po nim, licząc
+ * reszty z dzielenia wielomianu przez kolejne iloczyny. Wszystkie dzielniki
+ * są unormowane, więc dzielenie nie wymaga odwracania współczynników.
+ * Czas działania to @f$O(M(m) \log m)@f$ na każde @f$m@f$ punktów, gdzie
+ * @f$M@f$ to koszt mnożenia za pomocą NttMul.
+ * @param[in] coeffs : współczynniki wielomianu, @f$a_i@f$ przy @f$x^i@f$
+ * @param[in] len : liczba współczynników
+ * @param[in] points : punkty
+ * @param[in] n : liczba punktów
+ * @param[out] values : tablica na @p n wartości wielomianu
+ */
+void MultipointEval(const uint64_t* coeffs, size_t len,
+                    const uint64_t* points, size_t n, uint64_t* values);
+
+#endif /* MULTIPOINT_H */
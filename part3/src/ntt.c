@@ -0,0 +1,311 @@
+/** @file
+ *  Mnożenie gęstych wielomianów jednej zmiennej za pomocą
+ *  teorioliczbowej transformaty Fouriera (NTT).
+ *  @author Patrycja Stępień
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "ntt.h"
+
+/**
+ * Liczba całkowita bez znaku o długości 128 bitów (rozszerzenie GCC),
+ * używana do mnożenia 64-bitowych reszt.
+ */
+typedef unsigned __int128 uint128_t;
+
+/**
+ * Liczba modułów, z których odtwarzany jest wynik.
+ */
+#define PRIMES_COUNT 3
+
+/**
+ * Moduł NTT wraz ze stałymi arytmetyki Montgomery'ego.
+ * Wszystkie moduły są mniejsze niż @f$2^{62}@f$, więc suma dwóch reszt
+ * oraz wynik redukcji Montgomery'ego mieszczą się w 64 bitach.
+ */
+typedef struct NttPrime {
+    uint64_t p; ///< moduł postaci @f$c \cdot 2^k + 1@f$
+    uint64_t root; ///< pierwiastek pierwotny modulo @p p
+    uint64_t pInv; ///< @f$-p^{-1} \bmod 2^{64}@f$
+    uint64_t r2; ///< @f$2^{128} \bmod p@f$
+} NttPrime;
+
+/**
+ * Moduły NTT i ich pierwiastki pierwotne. Iloczyn modułów przekracza
+ * @f$2^{184}@f$, więc dla iloczynów długości co najwyżej NTT_MAX_LENGTH
+ * dokładna wartość każdego współczynnika splotu (mniejsza niż
+ * @f$n \cdot 2^{128}@f$) jest jednoznacznie wyznaczona przez reszty.
+ * Moduły są uporządkowane malejąco i @f$p_0 < 2 p_2@f$.
+ */
+static const uint64_t PRIMES[PRIMES_COUNT][2] = {
+    {4179340454199820289ULL, 3}, // 29 * 2^57 + 1
+    {3188548536178311169ULL, 7}, // 177 * 2^54 + 1
+    {2485986994308513793ULL, 5}, // 69 * 2^55 + 1
+};
+
+/**
+ * Redukcja Montgomery'ego: zwraca @f$t \cdot 2^{-64} \bmod p@f$.
+ * @param[in] t : redukowana liczba, @f$t < p \cdot 2^{64}@f$
+ * @param[in] prime : moduł
+ * @return zredukowana reszta z przedziału @f$[0, p)@f$
+ */
+static inline uint64_t MontReduce(uint128_t t, const NttPrime* prime) {
+    uint64_t m = (uint64_t) t * prime->pInv;
+    uint64_t u = (uint64_t) ((t + (uint128_t) m * prime->p) >> 64);
+    return u >= prime->p ? u - prime->p : u;
+}
+
+/**
+ * Mnoży dwie reszty w postaci Montgomery'ego.
+ * @param[in] a, b : mnożone reszty
+ * @param[in] prime : moduł
+ * @return @f$a \cdot b \cdot 2^{-64} \bmod p@f$
+ */
+static inline uint64_t MontMul(uint64_t a, uint64_t b, const NttPrime* prime) {
+    return MontReduce((uint128_t) a * b, prime);
+}
+
+/**
+ * Dodaje dwie reszty modulo @p p.
+ * @param[in] a, b : dodawane reszty
+ * @param[in] p : moduł
+ * @return @f$a + b \bmod p@f$
+ */
+static inline uint64_t ModAdd(uint64_t a, uint64_t b, uint64_t p) {
+    uint64_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+/**
+ * Odejmuje dwie reszty modulo @p p.
+ * @param[in] a, b : reszty
+ * @param[in] p : moduł
+ * @return @f$a - b \bmod p@f$
+ */
+static inline uint64_t ModSub(uint64_t a, uint64_t b, uint64_t p) {
+    return a >= b ? a - b : a + p - b;
+}
+
+/**
+ * Zamienia dowolną liczbę 64-bitową na resztę w postaci Montgomery'ego.
+ * @param[in] a : liczba
+ * @param[in] prime : moduł
+ * @return @f$a \cdot 2^{64} \bmod p@f$
+ */
+static inline uint64_t ToMont(uint64_t a, const NttPrime* prime) {
+    return MontMul(a, prime->r2, prime);
+}
+
+/**
+ * Podnosi resztę w postaci Montgomery'ego do potęgi.
+ * @param[in] basis : podstawa w postaci Montgomery'ego
+ * @param[in] exp : wykładnik
+ * @param[in] prime : moduł
+ * @return @f$basis^{exp}@f$ w postaci Montgomery'ego
+ */
+static uint64_t MontPow(uint64_t basis, uint64_t exp, const NttPrime* prime) {
+    uint64_t result = ToMont(1, prime);
+    while (exp > 0) {
+        if (exp % 2 == 1) {
+            result = MontMul(result, basis, prime);
+        }
+        basis = MontMul(basis, basis, prime);
+        exp /= 2;
+    }
+    return result;
+}
+
+/**
+ * Wyznacza stałe arytmetyki Montgomery'ego dla modułu.
+ * @param[in] p : moduł
+ * @param[in] root : pierwiastek pierwotny modulo @p p
+ * @return moduł wraz ze stałymi
+ */
+static NttPrime NttPrimeCreate(uint64_t p, uint64_t root) {
+    NttPrime prime;
+    prime.p = p;
+    prime.root = root;
+
+    // Metoda Newtona: każda iteracja podwaja liczbę poprawnych bitów odwrotności.
+    uint64_t inv = p;
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - p * inv;
+    }
+    prime.pInv = -inv;
+
+    uint64_t r = (uint64_t) (((uint128_t) 1 << 64) % p);
+    prime.r2 = (uint64_t) ((uint128_t) r * r % p);
+
+    return prime;
+}
+
+/**
+ * Zwraca odwrotność reszty modulo @p p (w postaci Montgomery'ego),
+ * korzystając z małego twierdzenia Fermata.
+ * @param[in] a : odwracana reszta w postaci Montgomery'ego
+ * @param[in] prime : moduł
+ * @return @f$a^{-1}@f$ w postaci Montgomery'ego
+ */
+static uint64_t MontInverse(uint64_t a, const NttPrime* prime) {
+    return MontPow(a, prime->p - 2, prime);
+}
+
+/**
+ * Przestawia elementy tablicy zgodnie z odwróceniem bitów indeksów.
+ * @param[in, out] a : tablica
+ * @param[in] n : długość tablicy, potęga dwójki
+ */
+static void BitReverse(uint64_t* a, size_t n) {
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            uint64_t swap = a[i];
+            a[i] = a[j];
+            a[j] = swap;
+        }
+    }
+}
+
+/**
+ * Wykonuje w miejscu transformatę NTT (lub odwrotną, bez dzielenia przez @p n).
+ * @param[in, out] a : reszty w postaci Montgomery'ego
+ * @param[in] n : długość transformaty, potęga dwójki
+ * @param[in] inverse : czy wykonać transformatę odwrotną
+ * @param[in] prime : moduł
+ * @param[out] roots : tablica pomocnicza na @f$n / 2@f$ pierwiastków z jedynki
+ */
+static void Transform(uint64_t* a, size_t n, bool inverse, const NttPrime* prime,
+                      uint64_t* roots) {
+    uint64_t p = prime->p;
+    uint64_t root = ToMont(prime->root, prime);
+    if (inverse) {
+        root = MontInverse(root, prime);
+    }
+
+    BitReverse(a, n);
+    for (size_t half = 1; half < n; half *= 2) {
+        uint64_t step = MontPow(root, (p - 1) / (2 * half), prime);
+        roots[0] = ToMont(1, prime);
+        for (size_t j = 1; j < half; j++) {
+            roots[j] = MontMul(roots[j - 1], step, prime);
+        }
+
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t j = 0; j < half; j++) {
+                uint64_t u = a[i + j];
+                uint64_t v = MontMul(a[i + j + half], roots[j], prime);
+                a[i + j] = ModAdd(u, v, p);
+                a[i + j + half] = ModSub(u, v, p);
+            }
+        }
+    }
+}
+
+/**
+ * Liczy iloczyn wielomianów modulo jeden moduł.
+ * @param[in] a, lenA, b, lenB : czynniki, jak w NttMul
+ * @param[in] n : długość transformaty
+ * @param[in] prime : moduł
+ * @param[out] residues : @f$n@f$ reszt współczynników iloczynu (w zwykłej postaci)
+ * @param[out] buffer, roots : tablice pomocnicze długości @f$n@f$ i @f$n / 2@f$
+ */
+static void MulModPrime(const uint64_t* a, size_t lenA, const uint64_t* b, size_t lenB,
+                        size_t n, const NttPrime* prime, uint64_t* residues,
+                        uint64_t* buffer, uint64_t* roots) {
+    // Kwadrat wymaga tylko jednej transformaty prostej.
+    bool square = a == b && lenA == lenB;
+    for (size_t i = 0; i < n; i++) {
+        residues[i] = i < lenA ? ToMont(a[i], prime) : 0;
+    }
+    Transform(residues, n, false, prime, roots);
+    const uint64_t* transformB = residues;
+    if (!square) {
+        for (size_t i = 0; i < n; i++) {
+            buffer[i] = i < lenB ? ToMont(b[i], prime) : 0;
+        }
+        Transform(buffer, n, false, prime, roots);
+        transformB = buffer;
+    }
+    for (size_t i = 0; i < n; i++) {
+        residues[i] = MontMul(residues[i], transformB[i], prime);
+    }
+    Transform(residues, n, true, prime, roots);
+
+    // Dzielenie przez n i powrót z postaci Montgomery'ego w jednym mnożeniu.
+    uint64_t nInv = MontInverse(ToMont(n, prime), prime);
+    for (size_t i = 0; i < n; i++) {
+        residues[i] = MontReduce(MontMul(residues[i], nInv, prime), prime);
+    }
+}
+
+/**
+ * Redukuje liczbę mniejszą niż @f$2p@f$ modulo @p p.
+ * @param[in] a : liczba, @f$a < 2p@f$
+ * @param[in] p : moduł
+ * @return @f$a \bmod p@f$
+ */
+static inline uint64_t ReduceOnce(uint64_t a, uint64_t p) {
+    return a >= p ? a - p : a;
+}
+
+void NttMul(const uint64_t* a, size_t lenA, const uint64_t* b, size_t lenB,
+            uint64_t* result) {
+    size_t len = lenA + lenB - 1;
+    size_t n = 1;
+    while (n < len) {
+        n *= 2;
+    }
+
+    NttPrime primes[PRIMES_COUNT];
+    for (size_t k = 0; k < PRIMES_COUNT; k++) {
+        primes[k] = NttPrimeCreate(PRIMES[k][0], PRIMES[k][1]);
+    }
+
+    uint64_t* residues[PRIMES_COUNT];
+    for (size_t k = 0; k < PRIMES_COUNT; k++) {
+        residues[k] = malloc(n * sizeof(uint64_t));
+        if (residues[k] == NULL) {
+            exit(1);
+        }
+    }
+    uint64_t* buffer = malloc(n * sizeof(uint64_t));
+    uint64_t* roots = malloc((n / 2 + 1) * sizeof(uint64_t));
+    if (buffer == NULL || roots == NULL) {
+        exit(1);
+    }
+
+    for (size_t k = 0; k < PRIMES_COUNT; k++) {
+        MulModPrime(a, lenA, b, lenB, n, &primes[k], residues[k], buffer, roots);
+    }
+    free(buffer);
+    free(roots);
+
+    // Algorytm Garnera: wynik to r0 + v1 * p0 + v2 * p0 * p1, gdzie
+    // v1 < p1 i v2 < p2, liczony modulo 2^64.
+    const NttPrime* p1 = &primes[1];
+    const NttPrime* p2 = &primes[2];
+    uint64_t p0Inv1 = MontInverse(ToMont(primes[0].p, p1), p1);
+    uint64_t p0Mod2 = ToMont(primes[0].p, p2);
+    uint64_t p0p1Inv2 = MontInverse(MontMul(p0Mod2, ToMont(p1->p, p2), p2), p2);
+    uint64_t p0p1 = primes[0].p * p1->p;
+
+    for (size_t i = 0; i < len; i++) {
+        uint64_t r0 = residues[0][i];
+        uint64_t v1 = MontMul(ModSub(residues[1][i], ReduceOnce(r0, p1->p), p1->p),
+                              p0Inv1, p1);
+        uint64_t t = ModSub(residues[2][i], ReduceOnce(r0, p2->p), p2->p);
+        t = ModSub(t, MontMul(v1, p0Mod2, p2), p2->p);
+        uint64_t v2 = MontMul(t, p0p1Inv2, p2);
+        result[i] = r0 + v1 * primes[0].p + v2 * p0p1;
+    }
+
+    for (size_t k = 0; k < PRIMES_COUNT; k++) {
+        free(residues[k]);
+    }
+}
@@ -0,0 +1,35 @@
+/** @file
+ *  Mnożenie gęstych wielomianów jednej zmiennej za pomocą
+ *  teorioliczbowej transformaty Fouriera (NTT).
+ *  @author Patrycja Stępień
+*/
+
+#ifndef NTT_H
+#define NTT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Maksymalna długość iloczynu obsługiwana przez NttMul.
+ */
+#define NTT_MAX_LENGTH ((size_t) 1 << 54)
+
+/**
+ * Mnoży dwa gęste wielomiany jednej zmiennej o współczynnikach modulo
+ * @f$2^{64}@f$. Iloczyn liczony jest modulo trzy liczby pierwsze postaci
+ * @f$c \cdot 2^k + 1@f$, a następnie odtwarzany z chińskiego twierdzenia
+ * o resztach, więc wynik jest identyczny z mnożeniem szkolnym modulo
+ * @f$2^{64}@f$. Jeśli oba czynniki są tą samą tablicą, liczony jest kwadrat
+ * z jedną transformatą prostą zamiast dwóch.
+ * @param[in] a : współczynniki pierwszego czynnika, @f$a_i@f$ przy @f$x^i@f$
+ * @param[in] lenA : liczba współczynników pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] lenB : liczba współczynników drugiego czynnika
+ * @param[out] result : tablica na @f$lenA + lenB - 1 \le@f$ NTT_MAX_LENGTH
+ *                      współczynników iloczynu
+ */
+void NttMul(const uint64_t* a, size_t lenA, const uint64_t* b, size_t lenB,
+            uint64_t* result);
+
+#endif /* NTT_H */
@@ -0,0 +1,204 @@
+/** @file
+ *  Implementacja buforowanego wypisywania wyników i komunikatów o błędach
+ *  @author Patrycja Stępień
+*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+
+/**
+ * Rozmiar bufora każdego ze strumieni.
+ */
+#define OUTPUT_BUFFER_SIZE ((size_t) 1 << 16)
+
+/**
+ * Miejsce w buforze wystarczające na zapis jednego jednomianu
+ * współczynnikowego "+(współczynnik,wykładnik)" albo liczby z końcem wiersza.
+ */
+#define OUTPUT_TOKEN_SIZE 64
+
+/**
+ * Najdłuższy zapis dziesiętny liczby 64-bitowej bez znaku.
+ */
+#define MAX_DECIMAL_DIGITS 20
+
+/**
+ * Zapisy dziesiętne liczb od 00 do 99, po dwa znaki na liczbę.
+ */
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * Bufor strumienia wyjściowego.
+ */
+typedef struct OutputBuffer {
+    char data[OUTPUT_BUFFER_SIZE]; ///< zbuforowane znaki
+    size_t size; ///< liczba zbuforowanych znaków
+    int fd; ///< deskryptor strumienia
+} OutputBuffer;
+
+/**
+ * Bufor standardowego wyjścia.
+ */
+static OutputBuffer outBuffer = {.size = 0, .fd = STDOUT_FILENO};
+
+/**
+ * Bufor standardowego wyjścia diagnostycznego.
+ */
+static OutputBuffer errBuffer = {.size = 0, .fd = STDERR_FILENO};
+
+/**
+ * Zapisuje całą zawartość bufora do jego strumienia. Przy błędzie zapisu
+ * zawartość bufora jest porzucana, tak jak robi to printf.
+ * @param[in, out] buffer : bufor
+ */
+static void FlushBuffer(OutputBuffer* buffer) {
+    const char* data = buffer->data;
+    size_t left = buffer->size;
+    while (left > 0) {
+        ssize_t written = write(buffer->fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        data += written;
+        left -= (size_t) written;
+    }
+    buffer->size = 0;
+}
+
+/**
+ * Przygotowuje bufor do zapisu zadanej liczby znaków. Najpierw opróżnia
+ * bufor drugiego strumienia, żeby wyniki i komunikaty o błędach trafiały
+ * do systemu w kolejności wykonywania poleceń.
+ * @param[in, out] buffer : bufor
+ * @param[in] needed : liczba znaków, nie większa od @ref OUTPUT_BUFFER_SIZE
+ * @return wskaźnik na pierwsze wolne miejsce w buforze
+ */
+static char* Reserve(OutputBuffer* buffer, size_t needed) {
+    OutputBuffer* other = buffer == &outBuffer ? &errBuffer : &outBuffer;
+    if (other->size > 0) {
+        FlushBuffer(other);
+    }
+    if (OUTPUT_BUFFER_SIZE - buffer->size < needed) {
+        FlushBuffer(buffer);
+    }
+    return buffer->data + buffer->size;
+}
+
+/**
+ * Zapisuje liczbę bez znaku w systemie dziesiętnym, po dwie cyfry naraz.
+ * @param[out] out : miejsce na co najmniej @ref MAX_DECIMAL_DIGITS znaków
+ * @param[in] value : liczba
+ * @return liczba zapisanych znaków
+ */
+static size_t FormatUnsigned(char* out, uint64_t value) {
+    char digits[MAX_DECIMAL_DIGITS];
+    char* pos = digits + MAX_DECIMAL_DIGITS;
+    while (value >= 100) {
+        pos -= 2;
+        memcpy(pos, DIGIT_PAIRS + 2 * (value % 100), 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        pos -= 2;
+        memcpy(pos, DIGIT_PAIRS + 2 * value, 2);
+    } else {
+        *(--pos) = (char) ('0' + value);
+    }
+    size_t length = (size_t) (digits + MAX_DECIMAL_DIGITS - pos);
+    memcpy(out, pos, length);
+    return length;
+}
+
+/**
+ * Zapisuje liczbę ze znakiem w systemie dziesiętnym.
+ * @param[out] out : miejsce na co najmniej @ref MAX_DECIMAL_DIGITS + 1 znaków
+ * @param[in] value : liczba
+ * @return liczba zapisanych znaków
+ */
+static size_t FormatSigned(char* out, int64_t value) {
+    if (value < 0) {
+        *out = '-';
+        return 1 + FormatUnsigned(out + 1, 0 - (uint64_t) value);
+    }
+    return FormatUnsigned(out, (uint64_t) value);
+}
+
+/**
+ * Zapisuje do bufora standardowego wyjścia wielomian niebędący
+ * współczynnikiem.
+ * @param[in] p : wielomian
+ */
+static void OutputMonos(const Poly *p) {
+    for (size_t i = 0; i < p->size; i++) {
+        const Mono* m = &(p->arr[i]);
+        char* pos = Reserve(&outBuffer, OUTPUT_TOKEN_SIZE);
+        char* begin = pos;
+        if (i > 0) {
+            *(pos++) = '+';
+        }
+        *(pos++) = '(';
+        if (PolyIsCoeff(&(m->p))) {
+            pos += FormatSigned(pos, m->p.coeff);
+        } else {
+            outBuffer.size += (size_t) (pos - begin);
+            OutputMonos(&(m->p));
+            pos = begin = Reserve(&outBuffer, OUTPUT_TOKEN_SIZE);
+        }
+        *(pos++) = ',';
+        pos += FormatSigned(pos, m->exp);
+        *(pos++) = ')';
+        outBuffer.size += (size_t) (pos - begin);
+    }
+}
+
+void OutputPoly(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        OutputLine(p->coeff);
+        return;
+    }
+    OutputMonos(p);
+    *Reserve(&outBuffer, 1) = '\n';
+    (outBuffer.size)++;
+}
+
+void OutputLine(long value) {
+    char* pos = Reserve(&outBuffer, OUTPUT_TOKEN_SIZE);
+    size_t length = FormatSigned(pos, value);
+    pos[length] = '\n';
+    outBuffer.size += length + 1;
+}
+
+void OutputError(int lineNumber, const char* message) {
+    size_t messageLength = strlen(message);
+    char* pos = Reserve(&errBuffer, OUTPUT_TOKEN_SIZE + messageLength);
+    char* begin = pos;
+    memcpy(pos, "ERROR ", 6);
+    pos += 6;
+    pos += FormatSigned(pos, lineNumber);
+    *(pos++) = ' ';
+    memcpy(pos, message, messageLength);
+    pos += messageLength;
+    *(pos++) = '\n';
+    errBuffer.size += (size_t) (pos - begin);
+}
+
+void OutputFlush(void) {
+    FlushBuffer(&outBuffer);
+    FlushBuffer(&errBuffer);
+}
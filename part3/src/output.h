@@ -0,0 +1,37 @@
+/** @file
+ *  Buforowane wypisywanie wyników i komunikatów o błędach kalkulatora
+ *  @author Patrycja Stępień
+*/
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "poly.h"
+
+/**
+ * Wypisuje wielomian na standardowe wyjście, zakończony znakiem nowej linii.
+ * @param[in] p : wielomian
+ */
+void OutputPoly(const Poly *p);
+
+/**
+ * Wypisuje liczbę całkowitą na standardowe wyjście, zakończoną znakiem
+ * nowej linii.
+ * @param[in] value : liczba
+ */
+void OutputLine(long value);
+
+/**
+ * Wypisuje na standardowe wyjście diagnostyczne komunikat o błędzie
+ * w postaci "ERROR <numer wiersza> <opis>".
+ * @param[in] lineNumber : numer wiersza
+ * @param[in] message : opis błędu
+ */
+void OutputError(int lineNumber, const char* message);
+
+/**
+ * Przekazuje systemowi całą zbuforowaną zawartość obu strumieni.
+ */
+void OutputFlush(void);
+
+#endif /* OUTPUT_H */
@@ -2,10 +2,16 @@
 */
 
 #include "poly.h"
+#include "ntt.h"
+#include "multipoint.h"
+#include "poly_alloc.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /**
  * Baza systemu dwójkowego, używane w algorytmie szybkiego potęgowania.
@@ -29,6 +35,62 @@
  */
 #define SINGLE_SIZE 1
 
+/**
+ * Minimalna liczba jednomianów każdego z czynników, od której mnożenie
+ * może być wykonane za pomocą NTT.
+ */
+#define NTT_MIN_TERMS 64
+
+/**
+ * Maksymalny stosunek długości gęstej tablicy współczynników do liczby
+ * jednomianów czynnika mnożonego za pomocą NTT.
+ */
+#define NTT_MAX_DENSITY_RATIO 8
+
+/**
+ * Minimalna liczba jednomianów każdego z czynników, od której mnożenie
+ * może być wykonane algorytmem Karatsuby.
+ */
+#define KARATSUBA_MIN_TERMS 32
+
+/**
+ * Długość tablic współczynników, poniżej której algorytm Karatsuby
+ * przechodzi na mnożenie szkolne.
+ */
+#define KARATSUBA_BASE_TERMS 16
+
+/**
+ * Minimalna liczba punktów, od której wartości wielomianu w wielu punktach
+ * mogą być liczone za pomocą drzewa iloczynów.
+ */
+#define MULTIPOINT_MIN_POINTS 8192
+
+/**
+ * Minimalna liczba jednomianów wielomianu, od której jego wartości w wielu
+ * punktach mogą być liczone za pomocą drzewa iloczynów.
+ */
+#define MULTIPOINT_MIN_TERMS 8192
+
+/**
+ * Maksymalna liczba punktów, dla których PolyAtMany przechowuje naraz wagi
+ * jednomianów wielomianu o niestałych współczynnikach.
+ */
+#define AT_MANY_BLOCK_POINTS 64
+
+/**
+ * Maksymalna liczba jednomianów wielomianu jednej zmiennej, przy której
+ * składanie wykonywane jest schematem Hornera zamiast metodą dziel
+ * i zwyciężaj. Schemat Hornera mnoży coraz większy wynik przez małe
+ * potęgi, co opłaca się tylko dla kilku jednomianów.
+ */
+#define COMPOSE_HORNER_MAX_TERMS 4
+
+/**
+ * Szacowany stosunek kosztu jednego kroku NTT (dla wszystkich modułów
+ * i transformat) do kosztu jednego kroku scalania kopcem.
+ */
+#define NTT_COST_FACTOR 32
+
 /**
  * Zwraca liczbę podniesioną do danej potęgi.
  * @param[in, out] basis : baza potęgowania
@@ -75,37 +137,370 @@ static poly_exp_t CompareMonos(const void* A, const void* B) {
 static Poly PolyOfSizeN(size_t n) {
     Poly new;
     new.size = n;
-    new.arr = malloc(n * sizeof(Mono));
-    if (new.arr == NULL) {
-        exit(1);
-    }
+    new.arr = PolyMalloc(n * sizeof(Mono));
 
     return new;
 }
 
+/**
+ * Początkowa pojemność tablicy unikalnych wielomianów.
+ */
+#define INTERN_TABLE_INIT_CAPACITY 64
+
+/**
+ * Element tablicy unikalnych wielomianów.
+ */
+typedef struct InternEntry {
+    Mono* arr; ///< tablica jednomianów lub NULL dla pustego miejsca
+    size_t size; ///< liczba jednomianów
+    uint64_t hash; ///< skrót tablicy jednomianów
+} InternEntry;
+
+/**
+ * Tablica unikalnych wielomianów z adresowaniem otwartym. Nie jest
+ * właścicielem przechowywanych tablic jednomianów: usuwa je z niej
+ * PolyDestroy, gdy znika ostatni właściciel.
+ */
+typedef struct InternTable {
+    InternEntry* entries; ///< elementy tablicy
+    size_t capacity; ///< pojemność, potęga dwójki
+    size_t count; ///< liczba zajętych miejsc
+} InternTable;
+
+/**
+ * Tablica unikalnych wielomianów bieżącego wątku.
+ */
+static _Thread_local InternTable internTable;
+
+/**
+ * Czy wielomiany wstawiane na stos mają być zastępowane unikalnymi?
+ */
+static _Thread_local bool internEnabled;
+
+/**
+ * Miesza bity 64-bitowej liczby (funkcja kończąca SplitMix64).
+ * @param[in] x : liczba
+ * @return wymieszana liczba
+ */
+static uint64_t HashMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Liczy skrót tablicy jednomianów, której współczynniki są liczbami lub
+ * unikalnymi wielomianami, więc wystarczy porównywać ich adresy.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return skrót
+ */
+static uint64_t InternHash(const Mono* arr, size_t size) {
+    uint64_t hash = HashMix(size);
+    for (size_t i = 0; i < size; i++) {
+        const Poly *p = &(arr[i].p);
+        uint64_t value = PolyIsCoeff(p) ? (uint64_t) p->coeff : (uint64_t) (uintptr_t) p->arr;
+        hash = HashMix(hash ^ (uint64_t) arr[i].exp);
+        hash = HashMix(hash ^ value ^ (PolyIsCoeff(p) ? 0 : 1));
+    }
+    return hash;
+}
+
+/**
+ * Sprawdza, czy dwie tablice jednomianów o unikalnych współczynnikach
+ * są równe.
+ * @param[in] a, b : tablice jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return Czy tablice są równe?
+ */
+static bool InternArrEq(const Mono* a, const Mono* b, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (a[i].exp != b[i].exp || a[i].p.arr != b[i].p.arr) {
+            return false;
+        }
+        if (PolyIsCoeff(&(a[i].p)) && a[i].p.coeff != b[i].p.coeff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Wyszukuje miejsce tablicy jednomianów w tablicy unikalnych wielomianów.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @param[in] hash : skrót tablicy jednomianów
+ * @return indeks równej tablicy lub pustego miejsca
+ */
+static size_t InternFindSlot(const Mono* arr, size_t size, uint64_t hash) {
+    size_t mask = internTable.capacity - 1;
+    size_t i = hash & mask;
+    while (internTable.entries[i].arr != NULL) {
+        InternEntry* e = &(internTable.entries[i]);
+        if (e->hash == hash && e->size == size && InternArrEq(e->arr, arr, size)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * Zmienia pojemność tablicy unikalnych wielomianów.
+ * @param[in] capacity : nowa pojemność, potęga dwójki
+ */
+static void InternTableResize(size_t capacity) {
+    InternTable old = internTable;
+    internTable.capacity = capacity;
+    internTable.entries = PolyMalloc(capacity * sizeof(InternEntry));
+    memset(internTable.entries, 0, capacity * sizeof(InternEntry));
+    for (size_t i = 0; i < old.capacity; i++) {
+        InternEntry* e = &(old.entries[i]);
+        if (e->arr != NULL) {
+            internTable.entries[InternFindSlot(e->arr, e->size, e->hash)] = *e;
+        }
+    }
+    PolyFree(old.entries);
+}
+
+/**
+ * Usuwa tablicę jednomianów z tablicy unikalnych wielomianów. Kolejne
+ * elementy tego samego ciągu przesuwa wstecz, żeby nie zostawiać luk.
+ * @param[in] p : wielomian, którego tablica jest unikalna
+ */
+static void InternTableRemove(const Poly *p) {
+    size_t mask = internTable.capacity - 1;
+    size_t i = InternFindSlot(p->arr, p->size, InternHash(p->arr, p->size));
+    internTable.entries[i].arr = NULL;
+    (internTable.count)--;
+
+    for (size_t j = (i + 1) & mask; internTable.entries[j].arr != NULL; j = (j + 1) & mask) {
+        size_t home = internTable.entries[j].hash & mask;
+        // Element może wypełnić lukę, jeśli jego miejsce docelowe nie leży
+        // cyklicznie między luką a nim samym.
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            internTable.entries[i] = internTable.entries[j];
+            internTable.entries[j].arr = NULL;
+            i = j;
+        }
+    }
+
+    if (internTable.count == 0) {
+        PolyFree(internTable.entries);
+        internTable = (InternTable) {.entries = NULL, .capacity = 0, .count = 0};
+    }
+}
+
+void PolySetInterning(bool enabled) {
+    internEnabled = enabled;
+}
+
+bool PolyIsInterning(void) {
+    return internEnabled;
+}
+
 void PolyDestroy(Poly *p) {
     if (PolyIsCoeff(p)) {
         p->coeff = 0;
     }
 
-    for (size_t i = 0; i < p->size; i++) {
-        MonoDestroy(&(p->arr[i]));
+    // Tablica jednomianów może być współdzielona z innymi wielomianami,
+    // zwalnia ją dopiero ostatni właściciel.
+    if (!PolyIsCoeff(p) && PolyBlockRelease(p->arr)) {
+        if (PolyBlockIsInterned(p->arr)) {
+            InternTableRemove(p);
+        }
+        for (size_t i = 0; i < p->size; i++) {
+            MonoDestroy(&(p->arr[i]));
+        }
+        PolyFree(p->arr);
     }
-    free(p->arr);
     p->size = 0;
+    p->arr = NULL;
 }
 
 Poly PolyClone(const Poly *p) {
+    if (!PolyIsCoeff(p)) {
+        PolyBlockRetain(p->arr);
+    }
+    return *p;
+}
+
+/**
+ * Liczba początkowych zmiennych, dla których metadane wielomianu
+ * przechowują stopień ze względu na zmienną.
+ */
+#define POLY_META_VARS 8
+
+/**
+ * Najmniejsza liczba jednomianów w drzewie wielomianu, od której jego
+ * metadane są zapamiętywane w nagłówku tablicy jednomianów. Metadane
+ * mniejszych wielomianów taniej jest policzyć ponownie.
+ */
+#define POLY_META_MIN_NODES 16
+
+/**
+ * Metadane wielomianu liczone z metadanych jego współczynników.
+ */
+typedef struct PolyMeta {
+    uint64_t hash; ///< skrót struktury wielomianu
+    size_t nodes; ///< liczba jednomianów we wszystkich tablicach wielomianu
+    size_t terms; ///< liczba jednomianów po rozwinięciu wielomianu
+    poly_exp_t degree; ///< stopień wielomianu
+    poly_exp_t depth; ///< liczba zagnieżdżonych poziomów tablic jednomianów
+    poly_exp_t degBy[POLY_META_VARS]; ///< stopnie ze względu na zmienne
+} PolyMeta;
+
+/**
+ * Wyznacza metadane wielomianu. Tablica jednomianów nie zmienia się, dopóki
+ * jest współdzielona, a przed każdą modyfikacją zapamiętane metadane są
+ * usuwane, więc raz policzone metadane dużego wielomianu można zwracać
+ * w czasie stałym. Metadane zapamiętywane są już przy tworzeniu tablicy
+ * (PolyFinishMeta), a tu liczone są tylko dla tablic utworzonych inaczej.
+ * @param[in] p : wielomian
+ * @param[out] meta : metadane wielomianu
+ */
+static void PolyGetMeta(const Poly *p, PolyMeta* meta) {
     if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->coeff);
-    } else {
-        Poly copiedPoly = PolyOfSizeN(p->size);
-        for (size_t i = 0; i < p->size; i++) {
-            copiedPoly.arr[i].p = PolyClone(&(p->arr[i].p));
-            copiedPoly.arr[i].exp = p->arr[i].exp;
+        *meta = (PolyMeta) {.hash = HashMix((uint64_t) p->coeff),
+                            .nodes = 0,
+                            .terms = p->coeff != 0 ? 1 : 0,
+                            .degree = p->coeff != 0 ? 0 : -1,
+                            .depth = 0};
+        return;
+    }
+    const PolyMeta* cached = PolyBlockMeta(p->arr);
+    if (cached != NULL) {
+        *meta = *cached;
+        return;
+    }
+
+    *meta = (PolyMeta) {.hash = HashMix(p->size), .nodes = p->size,
+                        .terms = 0, .degree = 0, .depth = 1};
+    // Jednomiany są posortowane rosnąco po wykładnikach.
+    meta->degBy[0] = p->arr[p->size - 1].exp;
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *coeff = &(p->arr[i].p);
+        poly_exp_t exp = p->arr[i].exp;
+        meta->hash = HashMix(meta->hash ^ (uint64_t) exp);
+        if (PolyIsCoeff(coeff)) {
+            // Współczynniki jednomianów w tablicy są niezerowe.
+            meta->terms++;
+            if (exp > meta->degree) {
+                meta->degree = exp;
+            }
+            meta->hash = HashMix(meta->hash ^ HashMix((uint64_t) coeff->coeff));
+            continue;
+        }
+
+        PolyMeta child;
+        PolyGetMeta(coeff, &child);
+        meta->nodes += child.nodes;
+        meta->terms += child.terms;
+        if (child.degree + exp > meta->degree) {
+            meta->degree = child.degree + exp;
+        }
+        if (child.depth + 1 > meta->depth) {
+            meta->depth = child.depth + 1;
+        }
+        // Stopnie ze względu na zmienne głębsze niż współczynnik są zerowe.
+        for (size_t v = 1; v < POLY_META_VARS && v <= (size_t) child.depth; v++) {
+            if (child.degBy[v - 1] > meta->degBy[v]) {
+                meta->degBy[v] = child.degBy[v - 1];
+            }
+        }
+        meta->hash = HashMix(meta->hash ^ child.hash);
+    }
+
+    if (meta->nodes >= POLY_META_MIN_NODES) {
+        PolyMeta* stored = PolyMalloc(sizeof(PolyMeta));
+        *stored = *meta;
+        PolyBlockSetMeta(p->arr, stored);
+    }
+}
+
+/**
+ * Zapamiętuje metadane wielomianu, którego tablica jednomianów została
+ * właśnie utworzona lub zmieniona. Metadane dużych współczynników są już
+ * zapamiętane, więc koszt jest proporcjonalny do liczby jednomianów
+ * najwyższego poziomu. Wielomian, który nawet z jednomianami pierwszego
+ * poziomu współczynników ma mniej niż POLY_META_MIN_NODES jednomianów,
+ * jest pomijany: jego metadane najpewniej i tak nie zostałyby zapamiętane.
+ * @param[in] p : wielomian
+ */
+static void PolyFinishMeta(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    size_t nodes = p->size;
+    for (size_t i = 0; i < p->size && nodes < POLY_META_MIN_NODES; i++) {
+        if (!PolyIsCoeff(&(p->arr[i].p))) {
+            nodes += p->arr[i].p.size;
         }
-        return copiedPoly;
     }
+    if (nodes >= POLY_META_MIN_NODES) {
+        PolyMeta meta;
+        PolyGetMeta(p, &meta);
+    }
+}
+
+/**
+ * Zapewnia, że wielomian jest jedynym właścicielem swojej tablicy
+ * jednomianów, zanim zostanie ona zmodyfikowana. Współdzieloną tablicę
+ * zastępuje kopią, która współdzieli z oryginałem współczynniki.
+ * @param[in, out] p : wielomian
+ */
+static void PolyMakeUnique(Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return;
+    }
+    if (!PolyBlockIsShared(p->arr) && !PolyBlockIsInterned(p->arr)) {
+        // Tablica zostanie zmodyfikowana, więc jej metadane są nieaktualne.
+        PolyBlockSetMeta(p->arr, NULL);
+        return;
+    }
+
+    Poly copy = PolyOfSizeN(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        copy.arr[i] = MonoClone(&(p->arr[i]));
+    }
+    PolyDestroy(p);
+    *p = copy;
+}
+
+Poly PolyIntern(Poly p) {
+    if (PolyIsCoeff(&p) || PolyBlockIsInterned(p.arr)) {
+        return p;
+    }
+
+    // Współczynniki zastępujemy unikalnymi, więc tablica musi być nasza.
+    PolyMakeUnique(&p);
+    for (size_t i = 0; i < p.size; i++) {
+        p.arr[i].p = PolyIntern(p.arr[i].p);
+    }
+
+    if (2 * (internTable.count + 1) > internTable.capacity) {
+        InternTableResize(internTable.capacity == 0 ? INTERN_TABLE_INIT_CAPACITY
+                                                    : 2 * internTable.capacity);
+    }
+    uint64_t hash = InternHash(p.arr, p.size);
+    size_t slot = InternFindSlot(p.arr, p.size, hash);
+    InternEntry* e = &(internTable.entries[slot]);
+    if (e->arr != NULL) {
+        Poly found = {.size = e->size, .arr = e->arr};
+        PolyDestroy(&p);
+        return PolyClone(&found);
+    }
+
+    *e = (InternEntry) {.arr = p.arr, .size = p.size, .hash = hash};
+    (internTable.count)++;
+    PolyBlockSetInterned(p.arr);
+    // Unikalna tablica nie będzie już zmieniana.
+    PolyFinishMeta(&p);
+    return p;
 }
 
 /**
@@ -257,14 +652,14 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
     DeepCopyArrayIntoAnother(q, indQ, &result, indNew);
 
     if (numOfDifferentElem == 0) {
-        free(result.arr);
+        PolyFree(result.arr);
         return PolyZero();
     }
 
     if (numOfDifferentElem == 1 && result.arr[0].exp == 0) {
         if (PolyIsCoeff(&(result.arr[0].p))) {
             result.coeff = result.arr[0].p.coeff;
-            free(result.arr);
+            PolyFree(result.arr);
             result.arr = NULL;
             return result;
         }
@@ -274,6 +669,7 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
     return result;
 }
 
+
 /**
  * Sprawdza, czy tablica jednomianów utworzy wielomian postaci @f$cx^0@f$.
  * @param[in, out] size : rozmiar tworzonego wielomianu
@@ -287,24 +683,196 @@ static bool IsCoeffTimesXToZero(size_t size, Mono const* newMonos) {
 }
 
 /**
- * Usuwa z pamięci tablicę jednomianów.
- * @param[out] arr : usuwana tablica jednomianów
- * @param[in] size : rozmiar usuwanej tablicy jednomianów
+ * Doprowadza akumulator do postaci kanonicznej po dodawaniu w miejscu:
+ * pusta tablica jednomianów oznacza zero, a jedyny współczynnik przy
+ * @f$x^0@f$ zastępuje cały wielomian.
+ * @param[in, out] acc : akumulator
  */
-static void MonoArrDestroy(Mono* arr, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-        PolyDestroy(&(arr[i].p));
+static void AccNormalize(Poly *acc) {
+    if (acc->size == 0) {
+        PolyFree(acc->arr);
+        *acc = PolyZero();
+    } else if (IsCoeffTimesXToZero(acc->size, acc->arr)) {
+        poly_coeff_t c = acc->arr[0].p.coeff;
+        PolyFree(acc->arr);
+        *acc = PolyFromCoeff(c);
+    }
+}
+
+/**
+ * Dodaje w miejscu współczynnik do wielomianu niebędącego współczynnikiem.
+ * @param[in, out] acc : wielomian niebędący współczynnikiem
+ * @param[in] c : niezerowy współczynnik
+ */
+static void AddCoeffTo(Poly *acc, Poly *c) {
+    PolyMakeUnique(acc);
+    if (acc->arr[0].exp == 0) {
+        PolyAddTo(&(acc->arr[0].p), c);
+        if (PolyIsZero(&(acc->arr[0].p))) {
+            memmove(acc->arr, acc->arr + 1, (acc->size - 1) * sizeof(Mono));
+            (acc->size)--;
+        }
+    } else {
+        acc->arr = PolyRealloc(acc->arr, (acc->size + 1) * sizeof(Mono));
+        memmove(acc->arr + 1, acc->arr, acc->size * sizeof(Mono));
+        acc->arr[0] = MonoFromPoly(c, 0);
+        (acc->size)++;
+    }
+    *c = PolyZero();
+    AccNormalize(acc);
+    PolyFinishMeta(acc);
+}
+
+void PolyAddTo(Poly *acc, Poly *consumed) {
+    if (PolyIsCoeff(consumed)) {
+        if (PolyIsCoeff(acc)) {
+            acc->coeff += consumed->coeff;
+        } else if (!PolyIsZero(consumed)) {
+            AddCoeffTo(acc, consumed);
+        }
+        *consumed = PolyZero();
+        return;
+    }
+    if (PolyIsCoeff(acc)) {
+        Poly swap = *acc;
+        *acc = *consumed;
+        *consumed = swap;
+        PolyAddTo(acc, consumed);
+        return;
+    }
+
+    // Scalamy od końca, dzięki czemu jednomiany akumulatora nie są
+    // nadpisywane przed przeniesieniem. Skrócone jednomiany zostawiają
+    // lukę na początku tablicy, którą usuwamy na końcu. Obie tablice
+    // są modyfikowane, więc nie mogą być współdzielone.
+    PolyMakeUnique(acc);
+    PolyMakeUnique(consumed);
+    size_t n = HowManyDifferentExp(acc, consumed);
+    acc->arr = PolyRealloc(acc->arr, n * sizeof(Mono));
+
+    size_t i = acc->size;
+    size_t j = consumed->size;
+    size_t k = n;
+    while (j > 0) {
+        if (i > 0 && acc->arr[i - 1].exp > consumed->arr[j - 1].exp) {
+            acc->arr[--k] = acc->arr[--i];
+        } else if (i > 0 && acc->arr[i - 1].exp == consumed->arr[j - 1].exp) {
+            Mono m = acc->arr[--i];
+            PolyAddTo(&(m.p), &(consumed->arr[--j].p));
+            if (!PolyIsZero(&(m.p))) {
+                acc->arr[--k] = m;
+            }
+        } else {
+            acc->arr[--k] = consumed->arr[--j];
+        }
+    }
+    // Pozostałe jednomiany akumulatora są już na swoich miejscach.
+    if (k > i) {
+        memmove(acc->arr + i, acc->arr + k, (n - k) * sizeof(Mono));
+    }
+    acc->size = i + n - k;
+
+    PolyFree(consumed->arr);
+    *consumed = PolyZero();
+    AccNormalize(acc);
+    PolyFinishMeta(acc);
+}
+
+void PolyAddMulTo(Poly *acc, const Poly *p, const Poly *q) {
+    Poly product = PolyMul(p, q);
+    PolyAddTo(acc, &product);
+}
+
+/**
+ * Liczba bitów wykładnika, według których jednomiany są rozdzielane
+ * w jednym przebiegu sortowania pozycyjnego.
+ */
+#define MONO_RADIX_BITS 8
+
+/**
+ * Liczba kubełków jednego przebiegu sortowania pozycyjnego.
+ */
+#define MONO_RADIX_BUCKETS (1 << MONO_RADIX_BITS)
+
+/**
+ * Liczba przebiegów sortowania pozycyjnego potrzebna dla całego wykładnika.
+ */
+#define MONO_RADIX_PASSES (sizeof(poly_exp_t) * CHAR_BIT / MONO_RADIX_BITS)
+
+/**
+ * Najmniejsza liczba jednomianów, od której opłaca się sortowanie
+ * pozycyjne zamiast qsort.
+ */
+#define MONO_RADIX_MIN_COUNT 256
+
+/**
+ * Sortuje stabilnie tablicę jednomianów rosnąco według wykładników,
+ * rozdzielając je do kubełków według kolejnych bajtów wykładnika, od
+ * najmniej znaczącego. Przebiegi, w których wszystkie jednomiany trafiają
+ * do jednego kubełka, są pomijane.
+ * @param[in, out] monoArray : sortowana tablica
+ * @param[in] count : rozmiar sortowanej tablicy jednomianów
+ */
+static void RadixSortMonos(Mono* monoArray, size_t count) {
+    size_t counts[MONO_RADIX_PASSES][MONO_RADIX_BUCKETS] = {{0}};
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = (uint32_t) monoArray[i].exp;
+        for (size_t pass = 0; pass < MONO_RADIX_PASSES; pass++) {
+            counts[pass][(key >> (pass * MONO_RADIX_BITS)) & (MONO_RADIX_BUCKETS - 1)]++;
+        }
     }
-    free(arr);
+
+    Mono* buffer = PolyMalloc(count * sizeof(Mono));
+    Mono* from = monoArray;
+    Mono* to = buffer;
+    for (size_t pass = 0; pass < MONO_RADIX_PASSES; pass++) {
+        size_t shift = pass * MONO_RADIX_BITS;
+        size_t* bucket = counts[pass];
+        if (bucket[((uint32_t) from[0].exp >> shift) & (MONO_RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t b = 0; b < MONO_RADIX_BUCKETS; b++) {
+            size_t size = bucket[b];
+            bucket[b] = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t key = (uint32_t) from[i].exp;
+            to[bucket[(key >> shift) & (MONO_RADIX_BUCKETS - 1)]++] = from[i];
+        }
+        Mono* swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != monoArray) {
+        memcpy(monoArray, from, count * sizeof(Mono));
+    }
+    PolyFree(buffer);
 }
 
 /**
- * Sortuje tablice jednomianów rosnąco według wykładników.
+ * Sortuje tablice jednomianów rosnąco według wykładników. Tablica już
+ * posortowana, na przykład utworzona przez parser, nie jest przestawiana.
  * @param[out] monoArray : sortowana tablica
  * @param[in] count : rozmiar sortowanej tablicy jednomianów
  */
 static void SortMonos(Mono* monoArray, size_t count) {
-    qsort(monoArray, count, sizeof(struct Mono), CompareMonos);
+    size_t sorted = 1;
+    while (sorted < count && monoArray[sorted - 1].exp <= monoArray[sorted].exp) {
+        sorted++;
+    }
+    if (sorted >= count) {
+        return;
+    }
+
+    if (count < MONO_RADIX_MIN_COUNT) {
+        qsort(monoArray, count, sizeof(struct Mono), CompareMonos);
+    } else {
+        RadixSortMonos(monoArray, count);
+    }
 }
 
 /**
@@ -313,10 +881,7 @@ static void SortMonos(Mono* monoArray, size_t count) {
  * @param[in] count : rozmiar kopiowanej tablicy jednomianów
  */
 static Mono* ShallowCopyOfMonoArr(const Mono* monos, size_t count) {
-    Mono* myMonos = malloc(count * sizeof(Mono));
-    if (myMonos == NULL) {
-        exit(1);
-    }
+    Mono* myMonos = PolyMalloc(count * sizeof(Mono));
     for (size_t i = 0; i < count; i++) {
         myMonos[i] = monos[i];
     }
@@ -329,10 +894,7 @@ static Mono* ShallowCopyOfMonoArr(const Mono* monos, size_t count) {
  * @param[in] count : rozmiar kopiowanej tablicy jednomianów
  */
 static Mono* DeepCopyofMonoArr(const Mono* monos, size_t count) {
-    Mono* myMonos = malloc(count * sizeof(Mono));
-    if (myMonos == NULL) {
-        exit(1);
-    }
+    Mono* myMonos = PolyMalloc(count * sizeof(Mono));
     for (size_t i = 0; i < count; i++) {
         myMonos[i] = MonoClone(&(monos[i]));
     }
@@ -340,102 +902,83 @@ static Mono* DeepCopyofMonoArr(const Mono* monos, size_t count) {
 }
 
 /**
- * Na podstawie tablicy myMonos wypełnia kolejną tablicę,
- * w której zsumowane są jednomiany o tych samych potęgach.
- * @param[in] myMonos : tablica jednomianów mogąca zawierać kilka jednomianów o tym samym wykładniku
- * @param[out] newMonos : tablica jednomianów bez powtórzonych wykładników
+ * Scala w miejscu jednomiany o tych samych wykładnikach w posortowanej
+ * tablicy, sumując ich współczynniki i usuwając jednomiany zerowe.
+ * @param[in, out] myMonos : posortowana tablica jednomianów mogąca
+ *                           zawierać kilka jednomianów o tym samym wykładniku
  * @param[in] count : rozmiar początkowej tablicy jednomianów
- * @param[in, out] newInd : indeks wynikowej tablicy
+ * @return liczba jednomianów pozostałych na początku tablicy
  */
-static void DeleteSameExponents(Mono* myMonos, Mono* newMonos,
-                                size_t count, size_t *newInd) {
-    if (count == 1) {
-        newMonos[*newInd] = myMonos[0];
-        (*newInd)++;
-    } else {
-        Poly sum = myMonos[0].p;
-
-        for (size_t i = 1; i < count; i++) {
-            if (myMonos[i].exp == myMonos[i - 1].exp) {
-                Poly sum2 = PolyAdd(&sum, &(myMonos[i].p));
-                PolyDestroy(&sum);
-                PolyDestroy(&(myMonos[i].p));
-                sum = sum2;
-            } else {
-                if (PolyIsZero(&sum)) {
-                    PolyDestroy(&sum);
-                    sum = myMonos[i].p;
-                    continue;
-                }
-                newMonos[*newInd].exp = myMonos[i - 1].exp;
-                newMonos[*newInd].p = sum;
-                sum = myMonos[i].p;
-                (*newInd)++;
-            }
+static size_t DeleteSameExponents(Mono* myMonos, size_t count) {
+    size_t newInd = 0;
+    size_t i = 0;
+    while (i < count) {
+        Mono sum = myMonos[i++];
+        while (i < count && myMonos[i].exp == sum.exp) {
+            PolyAddTo(&(sum.p), &(myMonos[i++].p));
         }
-
-        // Algorytm nie uwzględnia rozpatrywania ostatnich sumowanych elementów,
-        // są one uwzględniane w tym miejscu.
-        if (!PolyIsZero(&sum)) {
-            newMonos[*newInd].exp = myMonos[count - 1].exp;
-            newMonos[*newInd].p = sum;
-            (*newInd)++;
+        if (PolyIsZero(&(sum.p))) {
+            PolyDestroy(&(sum.p));
         } else {
-            PolyDestroy(&sum);
+            myMonos[newInd++] = sum;
         }
     }
-    free(myMonos);
+    return newInd;
 }
 
 /**
- * Tworzy wielomian na podstawie tablicy jednomianów. Przejmuje na własnośc tablicę oraz jej zawartość.
- * @param[in] count : rozmiar początkowej tablicy jednomianów
+ * Tworzy wielomian z posortowanej tablicy jednomianów o różnych wykładnikach
+ * i niezerowych współczynnikach. Przejmuje na własność tablicę oraz jej
+ * zawartość.
+ * @param[in] count : rozmiar tablicy jednomianów
  * @param[in] myMonos : tablica jednomianów z której powstaje wielomian
- * @return wielomian utworzony z początkowej tablicy
+ * @return wielomian utworzony z tablicy
  */
-static Poly PolyCreateFromMonos(size_t count, Mono* myMonos) {
-    if (count == 0 || myMonos == NULL) {
-        return PolyZero();
-    }
-
-    // Wielomian postaci 0x^k.
-    if (count == 1 && PolyIsZero(&(myMonos[0].p))) {
-        MonoArrDestroy(myMonos, count);
-        return PolyZero();
-    }
-
-    SortMonos(myMonos, count);
-
-    // Wynikowa tablica.
-    Mono* newMonos = malloc(count * sizeof(Mono));
-    if (newMonos == NULL) {
-        exit(1);
-    }
-    size_t newInd = 0;
-    // Zwalnia myMonos, w newMonos umieszcza oczekiwany wynik.
-    DeleteSameExponents(myMonos, newMonos, count, &newInd);
-
+static Poly PolyFromMergedMonos(size_t count, Mono* myMonos) {
     Poly result;
-    if (newInd == 0) {
-        MonoArrDestroy(newMonos, newInd);
+    if (count == 0) {
+        PolyFree(myMonos);
         return PolyZero();
     }
 
-    if (IsCoeffTimesXToZero(newInd, newMonos)) {
-        result.coeff = newMonos[0].p.coeff;
-        PolyDestroy(&(newMonos[0].p));
-        free(newMonos);
+    if (IsCoeffTimesXToZero(count, myMonos)) {
+        result.coeff = myMonos[0].p.coeff;
+        PolyFree(myMonos);
         result.arr = NULL;
         return result;
     }
 
-    result.arr = newMonos;
-    result.size = newInd;
+    result.arr = myMonos;
+    result.size = count;
+    PolyFinishMeta(&result);
     return result;
 }
 
+/**
+ * Tworzy wielomian na podstawie tablicy jednomianów. Przejmuje na własnośc tablicę oraz jej zawartość.
+ * @param[in] count : rozmiar początkowej tablicy jednomianów
+ * @param[in] myMonos : tablica jednomianów z której powstaje wielomian
+ * @return wielomian utworzony z początkowej tablicy
+ */
+static Poly PolyCreateFromMonos(size_t count, Mono* myMonos) {
+    if (count == 0 || myMonos == NULL) {
+        PolyFree(myMonos);
+        return PolyZero();
+    }
+
+    SortMonos(myMonos, count);
+    return PolyFromMergedMonos(DeleteSameExponents(myMonos, count), myMonos);
+}
+
 Poly PolyOwnMonos(size_t count, Mono* monos) {
-    Mono* myMonos = monos;
+    // Tablica użytkownika pochodzi z malloc, a wielomiany przechowują
+    // tablice przydzielone przez PolyMalloc.
+    if (count == 0 || monos == NULL) {
+        free(monos);
+        return PolyZero();
+    }
+    Mono* myMonos = ShallowCopyOfMonoArr(monos, count);
+    free(monos);
     return PolyCreateFromMonos(count, myMonos);
 }
 
@@ -449,9 +992,55 @@ Poly PolyAddMonos(size_t count, const Mono* monos) {
     return PolyCreateFromMonos(count, myMonos);
 }
 
-Poly PolyNeg(const Poly *p) {
-    if (PolyIsCoeff(p)) {
-        return PolyFromCoeff((-1) * p->coeff);
+/**
+ * Pojemność tablicy jednomianów budowniczego po pierwszym powiększeniu.
+ */
+#define POLY_BUILDER_MIN_CAPACITY 4
+
+PolyBuilder PolyBuilderCreate(size_t capacity) {
+    PolyBuilder builder = {.arr = NULL, .size = 0, .capacity = capacity, .sorted = true};
+    if (capacity > 0) {
+        builder.arr = PolyMalloc(capacity * sizeof(Mono));
+    }
+    return builder;
+}
+
+void PolyBuilderAppend(PolyBuilder *builder, Mono *m) {
+    if (PolyIsZero(&(m->p))) {
+        MonoDestroy(m);
+        return;
+    }
+    if (builder->size == builder->capacity) {
+        builder->capacity = builder->capacity > 0 ?
+                            2 * builder->capacity : POLY_BUILDER_MIN_CAPACITY;
+        builder->arr = PolyRealloc(builder->arr, builder->capacity * sizeof(Mono));
+    }
+    if (builder->size > 0 && builder->arr[builder->size - 1].exp >= m->exp) {
+        builder->sorted = false;
+    }
+    builder->arr[(builder->size)++] = *m;
+}
+
+Poly PolyBuilderFinish(PolyBuilder *builder) {
+    // Rosnące wykładniki i niezerowe współczynniki to już postać wielomianu.
+    Poly result = builder->sorted ?
+                  PolyFromMergedMonos(builder->size, builder->arr) :
+                  PolyCreateFromMonos(builder->size, builder->arr);
+    *builder = PolyBuilderCreate(0);
+    return result;
+}
+
+void PolyBuilderDestroy(PolyBuilder *builder) {
+    for (size_t i = 0; i < builder->size; i++) {
+        MonoDestroy(&(builder->arr[i]));
+    }
+    PolyFree(builder->arr);
+    *builder = PolyBuilderCreate(0);
+}
+
+Poly PolyNeg(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff((-1) * p->coeff);
     }
 
     Poly result = PolyOfSizeN(p->size);
@@ -459,200 +1048,1371 @@ Poly PolyNeg(const Poly *p) {
         Poly negatedPoly = PolyNeg(&p->arr[i].p);
         result.arr[i] = MonoFromPoly(&(negatedPoly), p->arr[i].exp);
     }
-    return result;
+    return result;
+}
+
+Poly PolySub(const Poly *p, const Poly *q) {
+    Poly result = PolyNeg(q);
+    Poly helperP = PolyClone(p);
+    PolyAddTo(&result, &helperP);
+    return result;
+}
+
+/**
+ * Neguje wielomian w miejscu. Współdzielone tablice jednomianów są
+ * najpierw kopiowane, więc inni ich właściciele nie widzą zmiany.
+ * @param[in, out] p : wielomian @f$p@f$, po wykonaniu @f$-p@f$
+ */
+static void PolyNegInPlace(Poly *p) {
+    if (PolyIsCoeff(p)) {
+        p->coeff = (-1) * p->coeff;
+        return;
+    }
+    PolyMakeUnique(p);
+    for (size_t i = 0; i < p->size; i++) {
+        PolyNegInPlace(&(p->arr[i].p));
+    }
+}
+
+void PolySubTo(Poly *acc, Poly *consumed) {
+    PolyNegInPlace(consumed);
+    PolyAddTo(acc, consumed);
+}
+
+/**
+ * Funkcja rekurencyjna obliczająca największy wykładnik przy zadanej zmiennej
+ * dla zmiennych, których stopni nie przechowują metadane.
+ * @param[in] p : wielomian dla którego liczymy najwyższy wykładnik przy danej zmiennej
+ * @param[in] varIdx : zmienna dla której liczmy maksymalny występujący wykładnik
+ * @return największy wykładnik przy zmiennej, 0 jeśli zmienna nie występuje
+ */
+static poly_exp_t PolyDegByHelper(const Poly *p, size_t varIdx) {
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
+    PolyMeta meta;
+    PolyGetMeta(p, &meta);
+    if (varIdx < POLY_META_VARS) {
+        return meta.degBy[varIdx];
+    }
+    if (varIdx >= (size_t) meta.depth) {
+        return 0;
+    }
+
+    poly_exp_t maxExpIdx = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t exp = PolyDegByHelper(&(p->arr[i].p), varIdx - 1);
+        if (exp > maxExpIdx) {
+            maxExpIdx = exp;
+        }
+    }
+    return maxExpIdx;
+}
+
+poly_exp_t PolyDegBy(const Poly *p, size_t varIdx) {
+    if (PolyIsZero(p)) {
+        return -1;
+    }
+    return PolyDegByHelper(p, varIdx);
+}
+
+poly_exp_t PolyDeg(const Poly *p) {
+    PolyMeta meta;
+    PolyGetMeta(p, &meta);
+    return meta.degree;
+}
+
+size_t PolyTermCount(const Poly *p) {
+    PolyMeta meta;
+    PolyGetMeta(p, &meta);
+    return meta.terms;
+}
+
+/**
+ * Funkcja rekurencyjna sprawdzająca równość dwóch wielomianów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+static bool PolyIsEqHelper(const Poly *p, const Poly *q) {
+    if (!PolyIsCoeff(p) && p->arr == q->arr) {
+        return true;
+    }
+    // Równe unikalne wielomiany mają tę samą tablicę jednomianów.
+    if (!PolyIsCoeff(p) && !PolyIsCoeff(q) &&
+        PolyBlockIsInterned(p->arr) && PolyBlockIsInterned(q->arr)) {
+        return false;
+    }
+    if ((PolyIsCoeff(p) && !PolyIsCoeff(q)) ||
+        (!PolyIsCoeff(p) && PolyIsCoeff(q))) {
+        return false;
+    }
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        return p->coeff == q->coeff;
+    }
+    if (p->size != q->size) {
+        return false;
+    }
+    // Różne skróty wykluczają równość. Metadane dużych tablic są zwykle
+    // zapamiętane przy ich tworzeniu, więc różne wielomiany odróżniamy
+    // bez przechodzenia ich drzew.
+    PolyMeta metaP, metaQ;
+    PolyGetMeta(p, &metaP);
+    PolyGetMeta(q, &metaQ);
+    if (metaP.hash != metaQ.hash) {
+        return false;
+    }
+
+    size_t numberOfX = p->size;
+    for (size_t i = 0; i < numberOfX; i++) {
+        if (p->arr[i].exp != q->arr[i].exp) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < numberOfX; i++) {
+        if (!PolyIsEqHelper(&(p->arr[i].p), &(q->arr[i].p))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PolyIsEq(const Poly *p, const Poly *q) {
+    return PolyIsEqHelper(p, q);
+}
+
+/**
+ * Element kopca wykorzystywanego przy mnożeniu wielomianów.
+ * Reprezentuje iloczyn jednomianu o indeksie @p i z pierwszego czynnika
+ * i jednomianu o indeksie @p j z drugiego czynnika.
+ */
+typedef struct MulHeapItem {
+    uint64_t key; ///< wykładnik (lub upakowany wektor wykładników) iloczynu
+    size_t i; ///< indeks jednomianu w pierwszym czynniku
+    size_t j; ///< indeks jednomianu w drugim czynniku
+} MulHeapItem;
+
+/**
+ * Kopiec minimalny (względem klucza) iloczynów jednomianów.
+ */
+typedef struct MulHeap {
+    MulHeapItem* arr; ///< tablica przechowująca kopiec
+    size_t size; ///< liczba elementów kopca
+} MulHeap;
+
+/**
+ * Tworzy pusty kopiec mieszczący @p n elementów.
+ * @param[in] n : maksymalna liczba elementów kopca
+ * @return pusty kopiec
+ */
+static MulHeap MulHeapCreate(size_t n) {
+    MulHeap heap;
+    heap.size = 0;
+    heap.arr = PolyMalloc(n * sizeof(MulHeapItem));
+    return heap;
+}
+
+/**
+ * Wstawia do kopca iloczyn jednomianów @f$p_i@f$ i @f$q_j@f$.
+ * Zakładamy, że w tablicy kopca jest miejsce na nowy element.
+ * @param[in, out] heap : kopiec
+ * @param[in] key : klucz iloczynu
+ * @param[in] i : indeks jednomianu w pierwszym czynniku
+ * @param[in] j : indeks jednomianu w drugim czynniku
+ */
+static void MulHeapPush(MulHeap* heap, uint64_t key, size_t i, size_t j) {
+    size_t ind = heap->size;
+    (heap->size)++;
+
+    while (ind > 0) {
+        size_t parent = (ind - 1) / 2;
+        if (heap->arr[parent].key <= key) {
+            break;
+        }
+        heap->arr[ind] = heap->arr[parent];
+        ind = parent;
+    }
+    heap->arr[ind] = (MulHeapItem) {.key = key, .i = i, .j = j};
+}
+
+/**
+ * Usuwa z kopca i zwraca element o najmniejszym kluczu.
+ * @param[in, out] heap : niepusty kopiec
+ * @return usunięty element
+ */
+static MulHeapItem MulHeapPop(MulHeap* heap) {
+    MulHeapItem top = heap->arr[0];
+    (heap->size)--;
+    MulHeapItem last = heap->arr[heap->size];
+
+    size_t ind = 0;
+    while (true) {
+        size_t child = 2 * ind + 1;
+        if (child >= heap->size) {
+            break;
+        }
+        if (child + 1 < heap->size && heap->arr[child + 1].key < heap->arr[child].key) {
+            child++;
+        }
+        if (last.key <= heap->arr[child].key) {
+            break;
+        }
+        heap->arr[ind] = heap->arr[child];
+        ind = child;
+    }
+    heap->arr[ind] = last;
+
+    return top;
+}
+
+/**
+ * Dopisuje jednomian na koniec tablicy jednomianów wielomianu wynikowego,
+ * w razie potrzeby dwukrotnie ją powiększając.
+ * @param[in, out] result : wielomian wynikowy
+ * @param[in, out] capacity : rozmiar zaalokowanej tablicy jednomianów
+ * @param[in] m : dopisywany jednomian
+ */
+static void AppendMono(Poly* result, size_t* capacity, Mono m) {
+    if (result->size == *capacity) {
+        *capacity = *capacity * 2;
+        result->arr = PolyRealloc(result->arr, *capacity * sizeof(Mono));
+    }
+    result->arr[result->size] = m;
+    (result->size)++;
+}
+
+/**
+ * Doprowadza do postaci kanonicznej wielomian, którego tablica jednomianów
+ * jest posortowana i nie zawiera zerowych współczynników, ale może być
+ * pusta lub zawierać jedynie współczynnik przy @f$x^0@f$.
+ * @param[in] p : wielomian
+ * @return wielomian w postaci kanonicznej
+ */
+static Poly PolyNormalize(Poly p) {
+    if (p.size == 0) {
+        PolyFree(p.arr);
+        return PolyZero();
+    }
+    if (IsCoeffTimesXToZero(p.size, p.arr)) {
+        poly_coeff_t c = p.arr[0].p.coeff;
+        PolyFree(p.arr);
+        return PolyFromCoeff(c);
+    }
+    PolyFinishMeta(&p);
+    return p;
+}
+
+/**
+ * Funkcja pomocnicza mnożąca dwa wielomiany które nie
+ * są współczynnikami. Iloczyny jednomianów generowane są w kolejności
+ * rosnących wykładników przez scalanie za pomocą kopca ciągów
+ * @f$p_i q_0, p_i q_1, \ldots@f$, więc iloczyny o równych wykładnikach
+ * sumowane są od razu, a każdy jednomian wyniku zapisywany jest tylko raz.
+ * Ciąg @f$p_{i+1} q_0, \ldots@f$ trafia do kopca dopiero po zdjęciu
+ * z niego @f$p_i q_0@f$, dzięki czemu kopiec jest jak najmniejszy.
+ * @param[in] poly1 : wielomian @f$p@f$
+ * @param[in] poly2 : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly MulTwoPolys(const Poly *poly1, const Poly *poly2) {
+    // Ciągi tworzymy dla krótszego czynnika, kopiec ma wtedy mniej elementów.
+    if (poly1->size > poly2->size) {
+        const Poly *swap = poly1;
+        poly1 = poly2;
+        poly2 = swap;
+    }
+
+    MulHeap heap = MulHeapCreate(poly1->size);
+    size_t capacity = poly2->size;
+    Poly result = PolyOfSizeN(capacity);
+    result.size = 0;
+
+    MulHeapPush(&heap, poly1->arr[0].exp + poly2->arr[0].exp, 0, 0);
+    while (heap.size > 0) {
+        poly_exp_t exp = heap.arr[0].key;
+        Poly sum = PolyZero();
+
+        while (heap.size > 0 && heap.arr[0].key == (uint64_t) exp) {
+            MulHeapItem item = MulHeapPop(&heap);
+            size_t i = item.i;
+            size_t j = item.j;
+
+            PolyAddMulTo(&sum, &(poly1->arr[i].p), &(poly2->arr[j].p));
+
+            if (j == 0 && i + 1 < poly1->size) {
+                MulHeapPush(&heap, poly1->arr[i + 1].exp + poly2->arr[0].exp, i + 1, 0);
+            }
+            if (j + 1 < poly2->size) {
+                MulHeapPush(&heap, poly1->arr[i].exp + poly2->arr[j + 1].exp, i, j + 1);
+            }
+        }
+
+        if (!PolyIsZero(&sum)) {
+            AppendMono(&result, &capacity, MonoFromPoly(&sum, exp));
+        }
+    }
+    PolyFree(heap.arr);
+
+    return PolyNormalize(result);
+}
+
+/**
+ * Mnoży dwa współczynniki modulo @f$2^{64}@f$, bez przepełnienia
+ * arytmetyki liczb ze znakiem.
+ * @param[in] a, b : mnożone współczynniki
+ * @return @f$a * b@f$
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+    return (poly_coeff_t) ((unsigned long) a * (unsigned long) b);
+}
+
+/**
+ * Dodaje dwa współczynniki modulo @f$2^{64}@f$, bez przepełnienia
+ * arytmetyki liczb ze znakiem.
+ * @param[in] a, b : dodawane współczynniki
+ * @return @f$a + b@f$
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+    return (poly_coeff_t) ((unsigned long) a + (unsigned long) b);
+}
+
+/**
+ * Mnoży wielomian przez współczynnik.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : współczynnik przez który mnożymy
+ * @return @f$c * q@f$
+ */
+static Poly PolyMulByCoeff(const Poly *p, poly_coeff_t c) {
+    if (c == 0) {
+        return PolyZero();
+    }
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffMul(p->coeff, c));
+    } else {
+        Poly result = PolyOfSizeN(p->size);
+        result.size = 0;
+
+        for (size_t i = 0; i < p->size; i++) {
+            Poly partialResult = PolyMulByCoeff(&(p->arr[i].p), c);
+            if (!PolyIsZero(&partialResult)) {
+                result.arr[result.size] = MonoFromPoly(&partialResult, p->arr[i].exp);
+                (result.size)++;
+            }
+        }
+
+        // Iloczyny mogą się zerować modulo 2^64, również poza x^0.
+        return PolyNormalize(result);
+    }
+}
+
+/**
+ * Potęgi punktu, w którym obliczamy wartość wielomianu, dla kolejnych
+ * różnic wykładników. Różnice często się powtarzają (np. w wielomianach
+ * gęstych są równe jeden), więc pamiętamy ostatnio obliczoną potęgę.
+ */
+typedef struct PowerCache {
+    poly_coeff_t x; ///< podstawa potęgi
+    poly_exp_t lastExp; ///< wykładnik ostatnio obliczonej potęgi
+    poly_coeff_t lastPower; ///< ostatnio obliczona potęga
+} PowerCache;
+
+/**
+ * Zwraca potęgę podstawy, korzystając z ostatnio obliczonej potęgi.
+ * @param[in, out] cache : potęgi podstawy
+ * @param[in] exp : wykładnik
+ * @return @f$x^{exp}@f$
+ */
+static poly_coeff_t CachedPower(PowerCache* cache, poly_exp_t exp) {
+    if (exp != cache->lastExp) {
+        cache->lastExp = exp;
+        cache->lastPower = exp == 1 ? cache->x : Exponentiation(cache->x, exp);
+    }
+    return cache->lastPower;
+}
+
+/**
+ * Oblicza wartość wielomianu jednej zmiennej o stałych współczynnikach
+ * rzadkim schematem Hornera: od najwyższego wykładnika w dół akumulator
+ * mnożony jest przez potęgę @p x o wykładniku równym różnicy sąsiednich
+ * wykładników.
+ * @param[in] p : wielomian, którego wszystkie współczynniki są stałymi
+ * @param[in] x : wartość argumentu
+ * @return @f$p(x)@f$
+ */
+static poly_coeff_t HornerAt(const Poly *p, poly_coeff_t x) {
+    PowerCache cache = {.x = x, .lastExp = 0, .lastPower = START_EXP_VALUE};
+    poly_coeff_t acc = 0;
+    for (size_t i = p->size; i-- > 0;) {
+        acc = CoeffAdd(acc, p->arr[i].p.coeff);
+        poly_exp_t gap = p->arr[i].exp - (i > 0 ? p->arr[i - 1].exp : 0);
+        acc = CoeffMul(acc, CachedPower(&cache, gap));
+    }
+    return acc;
+}
+
+/**
+ * Oblicza wartości wielomianu jednej zmiennej o stałych współczynnikach
+ * w wielu punktach rzadkim schematem Hornera. Tablica jednomianów
+ * przechodzona jest raz, a przy każdym jednomianie uaktualniane są
+ * akumulatory wszystkich punktów.
+ * @param[in] p : wielomian, którego wszystkie współczynniki są stałymi
+ * @param[in] n : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] values : tablica na @p n wartości
+ */
+static void HornerAtMany(const Poly *p, size_t n, const poly_coeff_t *xs, poly_coeff_t *values) {
+    PowerCache* caches = PolyMalloc(n * sizeof(PowerCache));
+    for (size_t i = 0; i < n; i++) {
+        caches[i] = (PowerCache) {.x = xs[i], .lastExp = 0, .lastPower = START_EXP_VALUE};
+        values[i] = 0;
+    }
+    for (size_t k = p->size; k-- > 0;) {
+        poly_coeff_t coeff = p->arr[k].p.coeff;
+        poly_exp_t gap = p->arr[k].exp - (k > 0 ? p->arr[k - 1].exp : 0);
+        for (size_t i = 0; i < n; i++) {
+            values[i] = CoeffMul(CoeffAdd(values[i], coeff), CachedPower(&caches[i], gap));
+        }
+    }
+    PolyFree(caches);
+}
+
+/**
+ * Wielomian z przypisaną wagą, składnik kombinacji liniowej.
+ */
+typedef struct WeightedPoly {
+    const Poly* p; ///< wielomian
+    poly_coeff_t w; ///< waga
+} WeightedPoly;
+
+/**
+ * Oblicza kombinację liniową wielomianów @f$\sum_i w_i p_i@f$. Tablice
+ * jednomianów składników scalane są naraz za pomocą kopca według
+ * wykładników, a współczynniki przy równych wykładnikach łączone są
+ * rekurencyjnie, więc każdy jednomian składnika odwiedzany jest raz.
+ * @param[in] terms : składniki kombinacji o niezerowych wagach
+ * @param[in] k : liczba składników
+ * @return kombinacja liniowa
+ */
+static Poly LinearCombination(const WeightedPoly* terms, size_t k) {
+    poly_coeff_t constant = 0;
+    size_t arrays = 0;
+    const WeightedPoly* single = NULL;
+    for (size_t i = 0; i < k; i++) {
+        if (PolyIsCoeff(terms[i].p)) {
+            constant = CoeffAdd(constant, CoeffMul(terms[i].w, terms[i].p->coeff));
+        } else {
+            single = &terms[i];
+            arrays++;
+        }
+    }
+    if (arrays == 0) {
+        return PolyFromCoeff(constant);
+    }
+    if (arrays == 1 && constant == 0) {
+        return single->w == 1 ? PolyClone(single->p) : PolyMulByCoeff(single->p, single->w);
+    }
+
+    // Ostatni element grupy może być stałą, dokładaną przy wykładniku zero.
+    Poly constantPoly = PolyFromCoeff(constant);
+    WeightedPoly* group = PolyMalloc((arrays + 1) * sizeof(WeightedPoly));
+    MulHeap heap = MulHeapCreate(arrays);
+    for (size_t i = 0; i < k; i++) {
+        if (!PolyIsCoeff(terms[i].p)) {
+            MulHeapPush(&heap, (uint64_t) terms[i].p->arr[0].exp, i, 0);
+        }
+    }
+
+    size_t capacity = arrays;
+    Poly result = PolyOfSizeN(capacity);
+    result.size = 0;
+    bool constantDone = constant == 0;
+    while (heap.size > 0 || !constantDone) {
+        poly_exp_t exp = heap.size > 0 ? (poly_exp_t) heap.arr[0].key : 0;
+        size_t n = 0;
+        if (!constantDone && (heap.size == 0 || exp > 0)) {
+            // Żaden składnik nie ma jednomianu przy x^0.
+            exp = 0;
+        }
+        while (heap.size > 0 && heap.arr[0].key == (uint64_t) exp) {
+            MulHeapItem item = MulHeapPop(&heap);
+            const Poly *p = terms[item.i].p;
+            group[n++] = (WeightedPoly) {.p = &(p->arr[item.j].p), .w = terms[item.i].w};
+            if (item.j + 1 < p->size) {
+                MulHeapPush(&heap, (uint64_t) p->arr[item.j + 1].exp, item.i, item.j + 1);
+            }
+        }
+        if (exp == 0 && !constantDone) {
+            group[n++] = (WeightedPoly) {.p = &constantPoly, .w = 1};
+            constantDone = true;
+        }
+
+        Poly coeff = LinearCombination(group, n);
+        if (!PolyIsZero(&coeff)) {
+            AppendMono(&result, &capacity, MonoFromPoly(&coeff, exp));
+        }
+    }
+    PolyFree(heap.arr);
+    PolyFree(group);
+
+    return PolyNormalize(result);
+}
+
+/**
+ * Sprawdza, czy wielomian jest wielomianem jednej zmiennej o stałych
+ * współczynnikach.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy wszystkie współczynniki @p p są stałymi?
+ */
+static bool HasCoeffCoefficients(const Poly *p) {
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyIsCoeff(&(p->arr[i].p))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Poly PolyAt(const Poly *p, poly_coeff_t x) {
+    if (PolyIsCoeff(p)) {
+        return PolyClone(p);
+    }
+
+    if (HasCoeffCoefficients(p)) {
+        return PolyFromCoeff(HornerAt(p, x));
+    }
+
+    // Wagi x^{e_i} liczymy przyrostowo, mnożąc poprzednią wagę przez
+    // potęgę x o wykładniku równym różnicy kolejnych wykładników.
+    PowerCache cache = {.x = x, .lastExp = 0, .lastPower = START_EXP_VALUE};
+    WeightedPoly* terms = PolyMalloc(p->size * sizeof(WeightedPoly));
+    size_t k = 0;
+    poly_coeff_t weight = START_EXP_VALUE;
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t gap = p->arr[i].exp - (i > 0 ? p->arr[i - 1].exp : 0);
+        weight = CoeffMul(weight, CachedPower(&cache, gap));
+        if (weight != 0) {
+            terms[k++] = (WeightedPoly) {.p = &(p->arr[i].p), .w = weight};
+        }
+    }
+
+    Poly result = LinearCombination(terms, k);
+    PolyFree(terms);
+    return result;
+}
+
+/**
+ * Oblicza wartości wielomianu o niestałych współczynnikach w wielu
+ * punktach. Dla każdego bloku AT_MANY_BLOCK_POINTS punktów tablica
+ * jednomianów przechodzona jest raz: przy każdym jednomianie uaktualniane
+ * są wagi @f$x^{e_i}@f$ wszystkich punktów bloku. Następnie dla każdego
+ * punktu liczona jest kombinacja liniowa współczynników, tak jak w PolyAt.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] n : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] results : tablica na @p n wyników
+ */
+static void PolyAtManyNested(const Poly *p, size_t n, const poly_coeff_t *xs, Poly *results) {
+    PowerCache caches[AT_MANY_BLOCK_POINTS];
+    poly_coeff_t weights[AT_MANY_BLOCK_POINTS];
+    size_t counts[AT_MANY_BLOCK_POINTS];
+    size_t block = n < AT_MANY_BLOCK_POINTS ? n : AT_MANY_BLOCK_POINTS;
+    WeightedPoly* terms = PolyMalloc(block * p->size * sizeof(WeightedPoly));
+
+    for (size_t start = 0; start < n; start += block) {
+        size_t m = n - start < block ? n - start : block;
+        for (size_t i = 0; i < m; i++) {
+            caches[i] = (PowerCache) {.x = xs[start + i], .lastExp = 0, .lastPower = START_EXP_VALUE};
+            weights[i] = START_EXP_VALUE;
+            counts[i] = 0;
+        }
+        for (size_t k = 0; k < p->size; k++) {
+            poly_exp_t gap = p->arr[k].exp - (k > 0 ? p->arr[k - 1].exp : 0);
+            for (size_t i = 0; i < m; i++) {
+                weights[i] = CoeffMul(weights[i], CachedPower(&caches[i], gap));
+                if (weights[i] != 0) {
+                    terms[i * p->size + counts[i]++] = (WeightedPoly) {.p = &(p->arr[k].p), .w = weights[i]};
+                }
+            }
+        }
+        for (size_t i = 0; i < m; i++) {
+            results[start + i] = LinearCombination(&terms[i * p->size], counts[i]);
+        }
+    }
+    PolyFree(terms);
+}
+
+/**
+ * Sprawdza, czy wartości wielomianu jednej zmiennej o stałych
+ * współczynnikach opłaca się liczyć za pomocą drzewa iloczynów.
+ * Wielomian musi być na tyle gęsty, by zmieścić się w tablicy
+ * współczynników, a punktów i jednomianów musi być na tyle dużo,
+ * by koszt budowy drzewa był mniejszy niż koszt schematu Hornera.
+ * @param[in] p : wielomian o stałych współczynnikach
+ * @param[in] n : liczba punktów
+ * @return Czy użyć MultipointEval?
+ */
+static bool IsMultipointWorthwhile(const Poly *p, size_t n) {
+    uint64_t len = (uint64_t) p->arr[p->size - 1].exp + 1;
+    return n >= MULTIPOINT_MIN_POINTS && p->size >= MULTIPOINT_MIN_TERMS &&
+           len <= (uint64_t) p->size * NTT_MAX_DENSITY_RATIO;
+}
+
+void PolyAtMany(const Poly *p, size_t n, const poly_coeff_t *xs, Poly *results) {
+    if (PolyIsCoeff(p)) {
+        for (size_t i = 0; i < n; i++) {
+            results[i] = PolyClone(p);
+        }
+        return;
+    }
+
+    if (!HasCoeffCoefficients(p)) {
+        PolyAtManyNested(p, n, xs, results);
+        return;
+    }
+
+    if (!IsMultipointWorthwhile(p, n)) {
+        poly_coeff_t* values = PolyMalloc(n * sizeof(poly_coeff_t));
+        HornerAtMany(p, n, xs, values);
+        for (size_t i = 0; i < n; i++) {
+            results[i] = PolyFromCoeff(values[i]);
+        }
+        PolyFree(values);
+        return;
+    }
+
+    size_t len = (size_t) p->arr[p->size - 1].exp + 1;
+    uint64_t* coeffs = PolyMalloc(len * sizeof(uint64_t));
+    memset(coeffs, 0, len * sizeof(uint64_t));
+    for (size_t i = 0; i < p->size; i++) {
+        coeffs[p->arr[i].exp] = (uint64_t) p->arr[i].p.coeff;
+    }
+    uint64_t* values = PolyMalloc(n * sizeof(uint64_t));
+    MultipointEval(coeffs, len, (const uint64_t*) xs, n, values);
+    for (size_t i = 0; i < n; i++) {
+        results[i] = PolyFromCoeff((poly_coeff_t) values[i]);
+    }
+    PolyFree(coeffs);
+    PolyFree(values);
+}
+
+/**
+ * Opis upakowania wektora wykładników @f$(e_0, e_1, \ldots, e_{n-1})@f$
+ * w jeden 64-bitowy klucz @f$\sum_i e_i \cdot stride_i@f$ (podstawienie
+ * Kroneckera). Zmienna @f$x_0@f$ jest najbardziej znacząca, więc porządek
+ * kluczy jest zgodny z porządkiem jednomianów w drzewie wielomianu.
+ */
+typedef struct KroneckerPacking {
+    size_t vars; ///< liczba zmiennych
+    uint64_t* bounds; ///< wykładnik zmiennej @f$x_i@f$ jest mniejszy niż bounds[i]
+    uint64_t* strides; ///< mnożnik wykładnika zmiennej @f$x_i@f$ w kluczu
+} KroneckerPacking;
+
+/**
+ * Wielomian w postaci spłaszczonej: posortowana rosnąco tablica kluczy
+ * wraz z odpowiadającymi im niezerowymi współczynnikami.
+ */
+typedef struct FlatPoly {
+    uint64_t* keys; ///< upakowane wektory wykładników
+    poly_coeff_t* coeffs; ///< współczynniki
+    size_t size; ///< liczba jednomianów
+    size_t capacity; ///< rozmiar zaalokowanych tablic
+} FlatPoly;
+
+/**
+ * Zwraca liczbę zmiennych wielomianu, czyli głębokość jego drzewa.
+ * @param[in] p : wielomian
+ * @return liczba zmiennych
+ */
+static size_t PolyVarCount(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return 0;
+    }
+    size_t maxVars = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        size_t vars = PolyVarCount(&(p->arr[i].p));
+        if (vars > maxVars) {
+            maxVars = vars;
+        }
+    }
+    return maxVars + 1;
+}
+
+/**
+ * Zwraca liczbę liści drzewa wielomianu, czyli liczbę jednomianów
+ * wielu zmiennych, z których się składa.
+ * @param[in] p : wielomian
+ * @return liczba liści
+ */
+static size_t PolyLeafCount(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        count += PolyLeafCount(&(p->arr[i].p));
+    }
+    return count;
+}
+
+/**
+ * Usuwa z pamięci opis upakowania wykładników.
+ * @param[out] packing : opis upakowania
+ */
+static void KroneckerPackingDestroy(KroneckerPacking* packing) {
+    PolyFree(packing->bounds);
+    PolyFree(packing->strides);
+}
+
+/**
+ * Wyznacza upakowanie wykładników iloczynu dwóch wielomianów, korzystając
+ * z ograniczeń @f$\deg_{x_i} pq \le \deg_{x_i} p + \deg_{x_i} q@f$.
+ * @param[in] p, q : niezerowe mnożone wielomiany
+ * @param[out] packing : wyznaczone upakowanie
+ * @return Czy wykładniki iloczynu mieszczą się w 64-bitowym kluczu?
+ */
+static bool KroneckerPackingCreate(const Poly *p, const Poly *q,
+                                   KroneckerPacking* packing) {
+    size_t varsP = PolyVarCount(p);
+    size_t varsQ = PolyVarCount(q);
+    packing->vars = varsP > varsQ ? varsP : varsQ;
+    packing->bounds = PolyMalloc(packing->vars * sizeof(uint64_t));
+    packing->strides = PolyMalloc(packing->vars * sizeof(uint64_t));
+
+    for (size_t i = 0; i < packing->vars; i++) {
+        packing->bounds[i] = (uint64_t) PolyDegBy(p, i) + (uint64_t) PolyDegBy(q, i) + 1;
+    }
+
+    uint64_t stride = 1;
+    for (size_t i = packing->vars; i-- > 0;) {
+        packing->strides[i] = stride;
+        if (stride > UINT64_MAX / packing->bounds[i]) {
+            KroneckerPackingDestroy(packing);
+            return false;
+        }
+        stride *= packing->bounds[i];
+    }
+    return true;
+}
+
+/**
+ * Tworzy pusty wielomian spłaszczony z miejscem na @p capacity jednomianów.
+ * @param[in] capacity : początkowy rozmiar tablic
+ * @return pusty wielomian spłaszczony
+ */
+static FlatPoly FlatPolyCreate(size_t capacity) {
+    FlatPoly flat;
+    flat.size = 0;
+    flat.capacity = capacity > 0 ? capacity : 1;
+    flat.keys = PolyMalloc(flat.capacity * sizeof(uint64_t));
+    flat.coeffs = PolyMalloc(flat.capacity * sizeof(poly_coeff_t));
+    return flat;
+}
+
+/**
+ * Usuwa z pamięci wielomian spłaszczony.
+ * @param[out] flat : wielomian spłaszczony
+ */
+static void FlatPolyDestroy(FlatPoly* flat) {
+    PolyFree(flat->keys);
+    PolyFree(flat->coeffs);
+}
+
+/**
+ * Dopisuje jednomian na koniec wielomianu spłaszczonego, w razie potrzeby
+ * dwukrotnie powiększając jego tablice.
+ * @param[in, out] flat : wielomian spłaszczony
+ * @param[in] key : klucz jednomianu
+ * @param[in] coeff : współczynnik jednomianu
+ */
+static void FlatPolyAppend(FlatPoly* flat, uint64_t key, poly_coeff_t coeff) {
+    if (flat->size == flat->capacity) {
+        flat->capacity *= 2;
+        flat->keys = PolyRealloc(flat->keys, flat->capacity * sizeof(uint64_t));
+        flat->coeffs = PolyRealloc(flat->coeffs, flat->capacity * sizeof(poly_coeff_t));
+    }
+    flat->keys[flat->size] = key;
+    flat->coeffs[flat->size] = coeff;
+    (flat->size)++;
+}
+
+/**
+ * Rekurencyjnie spłaszcza wielomian, dopisując jego jednomiany
+ * w kolejności rosnących kluczy.
+ * @param[in] p : wielomian nad zmienną @f$x_{level}@f$
+ * @param[in] key : klucz wyznaczony przez wykładniki zmiennych wyższego poziomu
+ * @param[in] level : indeks zmiennej
+ * @param[in] packing : upakowanie wykładników
+ * @param[in, out] flat : wielomian spłaszczony
+ */
+static void Flatten(const Poly *p, uint64_t key, size_t level,
+                    const KroneckerPacking* packing, FlatPoly* flat) {
+    if (PolyIsCoeff(p)) {
+        FlatPolyAppend(flat, key, p->coeff);
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        Flatten(&(p->arr[i].p), key + (uint64_t) p->arr[i].exp * packing->strides[level],
+                level + 1, packing, flat);
+    }
+}
+
+/**
+ * Mnoży dwa wielomiany spłaszczone scalając za pomocą kopca ciągi
+ * @f$a_i b_0, a_i b_1, \ldots@f$, tak jak MulTwoPolys.
+ * @param[in] a, b : niepuste wielomiany spłaszczone
+ * @return iloczyn wielomianów
+ */
+static FlatPoly FlatMulHeap(const FlatPoly* a, const FlatPoly* b) {
+    if (a->size > b->size) {
+        const FlatPoly* swap = a;
+        a = b;
+        b = swap;
+    }
+
+    MulHeap heap = MulHeapCreate(a->size);
+    FlatPoly result = FlatPolyCreate(b->size);
+
+    MulHeapPush(&heap, a->keys[0] + b->keys[0], 0, 0);
+    while (heap.size > 0) {
+        uint64_t key = heap.arr[0].key;
+        poly_coeff_t sum = 0;
+
+        while (heap.size > 0 && heap.arr[0].key == key) {
+            MulHeapItem item = MulHeapPop(&heap);
+            size_t i = item.i;
+            size_t j = item.j;
+
+            sum = CoeffAdd(sum, CoeffMul(a->coeffs[i], b->coeffs[j]));
+
+            if (j == 0 && i + 1 < a->size) {
+                MulHeapPush(&heap, a->keys[i + 1] + b->keys[0], i + 1, 0);
+            }
+            if (j + 1 < b->size) {
+                MulHeapPush(&heap, a->keys[i] + b->keys[j + 1], i, j + 1);
+            }
+        }
+
+        if (sum != 0) {
+            FlatPolyAppend(&result, key, sum);
+        }
+    }
+    PolyFree(heap.arr);
+
+    return result;
+}
+
+/**
+ * Podnosi do kwadratu wielomian spłaszczony, scalając za pomocą kopca ciągi
+ * @f$a_i a_i, a_i a_{i+1}, \ldots@f$. Iloczyn dwóch różnych jednomianów
+ * występuje w kwadracie dwukrotnie, więc liczony jest raz i podwajany.
+ * Ciąg @f$a_{i+1} a_{i+1}@f$ trafia do kopca dopiero po zdjęciu
+ * z niego @f$a_i a_i@f$.
+ * @param[in] a : niepusty wielomian spłaszczony
+ * @return kwadrat wielomianu
+ */
+static FlatPoly FlatSqrHeap(const FlatPoly* a) {
+    MulHeap heap = MulHeapCreate(a->size);
+    FlatPoly result = FlatPolyCreate(2 * a->size);
+
+    MulHeapPush(&heap, 2 * a->keys[0], 0, 0);
+    while (heap.size > 0) {
+        uint64_t key = heap.arr[0].key;
+        poly_coeff_t squares = 0;
+        poly_coeff_t products = 0;
+
+        while (heap.size > 0 && heap.arr[0].key == key) {
+            MulHeapItem item = MulHeapPop(&heap);
+            size_t i = item.i;
+            size_t j = item.j;
+
+            if (i == j) {
+                squares = CoeffAdd(squares, CoeffMul(a->coeffs[i], a->coeffs[i]));
+                if (i + 1 < a->size) {
+                    MulHeapPush(&heap, 2 * a->keys[i + 1], i + 1, i + 1);
+                }
+            } else {
+                products = CoeffAdd(products, CoeffMul(a->coeffs[i], a->coeffs[j]));
+            }
+            if (j + 1 < a->size) {
+                MulHeapPush(&heap, a->keys[i] + a->keys[j + 1], i, j + 1);
+            }
+        }
+
+        poly_coeff_t sum = CoeffAdd(squares, CoeffAdd(products, products));
+        if (sum != 0) {
+            FlatPolyAppend(&result, key, sum);
+        }
+    }
+    PolyFree(heap.arr);
+
+    return result;
+}
+
+/**
+ * Rozpakowuje wielomian spłaszczony do gęstej tablicy współczynników.
+ * @param[in] flat : niepusty wielomian spłaszczony
+ * @param[out] len : długość tablicy, czyli największy klucz powiększony o jeden
+ * @return tablica współczynników, na pozycji @f$k@f$ współczynnik przy kluczu @f$k@f$
+ */
+static uint64_t* FlatToDense(const FlatPoly* flat, size_t* len) {
+    *len = flat->keys[flat->size - 1] + 1;
+    uint64_t* dense = PolyMalloc(*len * sizeof(uint64_t));
+    memset(dense, 0, *len * sizeof(uint64_t));
+    for (size_t i = 0; i < flat->size; i++) {
+        dense[flat->keys[i]] = (uint64_t) flat->coeffs[i];
+    }
+    return dense;
+}
+
+/**
+ * Mnoży dwa gęste wielomiany spłaszczone za pomocą NTT.
+ * Klucze iloczynu nie przenoszą się między wykładnikami kolejnych zmiennych,
+ * więc współczynnik przy kluczu @f$k@f$ jest @f$k@f$-tym współczynnikiem
+ * splotu gęstych tablic. Kwadrat wielomianu (@p a równe @p b) liczony jest
+ * z jednej gęstej tablicy.
+ * @param[in] a, b : niepuste wielomiany spłaszczone
+ * @return iloczyn wielomianów
+ */
+static FlatPoly FlatMulDense(const FlatPoly* a, const FlatPoly* b) {
+    size_t lenA, lenB;
+    uint64_t* denseA = FlatToDense(a, &lenA);
+    uint64_t* denseB = denseA;
+    lenB = lenA;
+    if (b != a) {
+        denseB = FlatToDense(b, &lenB);
+    }
+
+    size_t len = lenA + lenB - 1;
+    uint64_t* product = PolyMalloc(len * sizeof(uint64_t));
+    NttMul(denseA, lenA, denseB, lenB, product);
+    if (denseB != denseA) {
+        PolyFree(denseB);
+    }
+    PolyFree(denseA);
+
+    FlatPoly result = FlatPolyCreate(a->size + b->size);
+    for (size_t k = 0; k < len; k++) {
+        if (product[k] != 0) {
+            FlatPolyAppend(&result, k, (poly_coeff_t) product[k]);
+        }
+    }
+    PolyFree(product);
+
+    return result;
+}
+
+/**
+ * Zwraca logarytm dwójkowy liczby zaokrąglony w górę.
+ * @param[in] n : liczba dodatnia
+ * @return @f$\lceil \log_2 n \rceil@f$
+ */
+static uint64_t CeilLog2(uint64_t n) {
+    uint64_t log = 0;
+    while (((uint64_t) 1 << log) < n) {
+        log++;
+    }
+    return log;
 }
 
-Poly PolySub(const Poly *p, const Poly *q) {
-    Poly helperQ = PolyNeg(q);
-    Poly result = PolyAdd(p, &helperQ);
-    PolyDestroy(&helperQ);
-    return result;
+/**
+ * Sprawdza, czy iloczyn wielomianów spłaszczonych opłaca się liczyć
+ * za pomocą NTT, czyli czy oba czynniki są dostatecznie duże i gęste,
+ * a szacowany koszt transformat jest mniejszy niż koszt scalania kopcem.
+ * @param[in] sizeA, sizeB : liczby jednomianów czynników
+ * @param[in] lenA, lenB : największe klucze czynników powiększone o jeden
+ * @return Czy użyć NTT?
+ */
+static bool IsNttWorthwhile(size_t sizeA, uint64_t lenA, size_t sizeB, uint64_t lenB) {
+    if (sizeA < NTT_MIN_TERMS || sizeB < NTT_MIN_TERMS) {
+        return false;
+    }
+    if (lenA > NTT_MAX_DENSITY_RATIO * sizeA || lenB > NTT_MAX_DENSITY_RATIO * sizeB) {
+        return false;
+    }
+    if (lenA + lenB - 1 > NTT_MAX_LENGTH) {
+        return false;
+    }
+
+    uint64_t n = (uint64_t) 1 << CeilLog2(lenA + lenB - 1);
+    size_t minSize = sizeA < sizeB ? sizeA : sizeB;
+    uint64_t heapCost = (uint64_t) sizeA * sizeB * (CeilLog2(minSize) + 1);
+    uint64_t nttCost = NTT_COST_FACTOR * n * (CeilLog2(n) + 1);
+    return nttCost < heapCost;
 }
 
 /**
- * Funkcja rekurencyjna obliczająca największy wykładnik przy zadanej zmiennej.
- * @param[in] p : wielomian dla którego liczymy najwyższy wykładnik przy danej zmiennej
- * @param[in] varIdx : zmienna dla której liczmy maksymalny występujący wykładnik
- * @param[in] countRecursion : aktualna głębokość wywołania rekurencyjnego
- * @param[in] maxExpIdx : szukana maksymalna wartość wykładnika
- */
-static void PolyDegByHelper(const Poly *p, size_t varIdx,
-                            size_t countRecursion, poly_exp_t* maxExpIdx) {
-    if (varIdx > countRecursion) {
-        if (!PolyIsCoeff(p)) {
-            for (size_t i = 0; i < p->size; i++) {
-                PolyDegByHelper(&(p->arr[i].p), varIdx,
-                                countRecursion + 1, maxExpIdx);
-            }
-        } else {
-            *maxExpIdx = 0;
-        }
-    } else if (varIdx == countRecursion) {
-        if (!PolyIsCoeff(p)) {
-            poly_exp_t maxExp = 0;
-            for (size_t i = 0; i < p->size; i++) {
-                if (p->arr[i].exp > maxExp) {
-                    maxExp = p->arr[i].exp;
-                }
-            }
-            if (maxExp > *maxExpIdx) {
-                *maxExpIdx = maxExp;
-            }
-        }
+ * Mnoży dwa wielomiany spłaszczone, wybierając algorytm: NTT dla gęstych
+ * dużych czynników, scalanie kopcem w pozostałych przypadkach.
+ * @param[in] a, b : niepuste wielomiany spłaszczone, równe wskaźniki
+ *                   oznaczają kwadrat
+ * @return iloczyn wielomianów
+ */
+static FlatPoly FlatMul(const FlatPoly* a, const FlatPoly* b) {
+    if (IsNttWorthwhile(a->size, a->keys[a->size - 1] + 1,
+                        b->size, b->keys[b->size - 1] + 1)) {
+        return FlatMulDense(a, b);
+    }
+    if (a == b) {
+        return FlatSqrHeap(a);
     }
+    return FlatMulHeap(a, b);
 }
 
-poly_exp_t PolyDegBy(const Poly *p, size_t varIdx) {
-    if (PolyIsZero(p)) {
-        return -1;
-    }
-    poly_exp_t maxExpIdx = 0;
-    PolyDegByHelper(p, varIdx, 0, &maxExpIdx);
-    return maxExpIdx;
+/**
+ * Zwraca wykładnik zmiennej @f$x_{level}@f$ zapisany w kluczu.
+ * @param[in] key : klucz
+ * @param[in] level : indeks zmiennej
+ * @param[in] packing : upakowanie wykładników
+ * @return wykładnik
+ */
+static poly_exp_t KeyGetExp(uint64_t key, size_t level, const KroneckerPacking* packing) {
+    return (poly_exp_t) ((key / packing->strides[level]) % packing->bounds[level]);
 }
 
 /**
- * Funkcja rekurencyjna obliczająca największy stopień wielomianu dla wszystkich zmiennych.
- * @param[in] p : wielomian dla którego liczymy najwyższy wykładnik
- * @param[in, out] currentMaxExp : obliczony największy do tej pory wykładnik
- * @param[out] maxExp : wynikowy największy wykładnik wielomianu
+ * Odtwarza drzewo wielomianu z przedziału jednomianów wielomianu
+ * spłaszczonego, których wykładniki zmiennych @f$x_0, \ldots, x_{level-1}@f$
+ * są równe.
+ * @param[in] flat : wielomian spłaszczony
+ * @param[in] begin : pierwszy indeks przedziału
+ * @param[in] end : za ostatni indeks przedziału
+ * @param[in] level : indeks zmiennej
+ * @param[in] packing : upakowanie wykładników
+ * @return wielomian nad zmienną @f$x_{level}@f$
  */
-static void PolyGetMaxExp(const Poly *p, poly_exp_t currentMaxExp, poly_exp_t* maxExp) {
-    if (!PolyIsCoeff(p)) {
-        for (size_t i = 0; i < p->size; i++) {
-            PolyGetMaxExp(&(p->arr[i].p),currentMaxExp + p->arr[i].exp, maxExp);
+static Poly Unflatten(const FlatPoly* flat, size_t begin, size_t end, size_t level,
+                      const KroneckerPacking* packing) {
+    if (level == packing->vars) {
+        return PolyFromCoeff(flat->coeffs[begin]);
+    }
+
+    size_t count = 1;
+    for (size_t i = begin + 1; i < end; i++) {
+        if (KeyGetExp(flat->keys[i], level, packing) !=
+            KeyGetExp(flat->keys[i - 1], level, packing)) {
+            count++;
         }
-    } else {
-        if (currentMaxExp > *maxExp) {
-            *maxExp = currentMaxExp;
+    }
+
+    Poly result = PolyOfSizeN(count);
+    size_t groupBegin = begin;
+    for (size_t ind = 0; ind < count; ind++) {
+        poly_exp_t exp = KeyGetExp(flat->keys[groupBegin], level, packing);
+        size_t groupEnd = groupBegin + 1;
+        while (groupEnd < end && KeyGetExp(flat->keys[groupEnd], level, packing) == exp) {
+            groupEnd++;
         }
+        Poly coeff = Unflatten(flat, groupBegin, groupEnd, level + 1, packing);
+        result.arr[ind] = MonoFromPoly(&coeff, exp);
+        groupBegin = groupEnd;
     }
+
+    return PolyNormalize(result);
 }
 
-poly_exp_t PolyDeg(const Poly *p) {
-    if (PolyIsZero(p)) {
-        return -1;
+/**
+ * Mnoży dwa wielomiany przez podstawienie Kroneckera: oba czynniki
+ * spłaszczane są do wielomianów jednej zmiennej o upakowanych
+ * wykładnikach, mnożone w jednej pętli bez rekurencji po poziomach,
+ * a wynik jest z powrotem rozpakowywany do drzewa. Kwadrat wielomianu
+ * (@p p równe @p q) spłaszczany jest raz.
+ * @param[in] p, q : wielomiany niebędące współczynnikami
+ * @param[in] packing : upakowanie wykładników iloczynu
+ * @return @f$p * q@f$
+ */
+static Poly MulByKronecker(const Poly *p, const Poly *q, const KroneckerPacking* packing) {
+    FlatPoly flatP = FlatPolyCreate(PolyLeafCount(p));
+    Flatten(p, 0, 0, packing, &flatP);
+
+    FlatPoly product;
+    if (q == p) {
+        product = FlatMul(&flatP, &flatP);
+    } else {
+        FlatPoly flatQ = FlatPolyCreate(PolyLeafCount(q));
+        Flatten(q, 0, 0, packing, &flatQ);
+        product = FlatMul(&flatP, &flatQ);
+        FlatPolyDestroy(&flatQ);
+    }
+    FlatPolyDestroy(&flatP);
+
+    Poly result = PolyZero();
+    if (product.size > 0) {
+        result = Unflatten(&product, 0, product.size, 0, packing);
     }
-    poly_exp_t maxExp = 0;
-    PolyGetMaxExp(p, 0, &maxExp);
-    return maxExp;
+    FlatPolyDestroy(&product);
+
+    return result;
 }
 
-bool PolyIsEq(const Poly *p, const Poly *q) {
-    if ((PolyIsCoeff(p) && !PolyIsCoeff(q)) ||
-        (!PolyIsCoeff(p) && PolyIsCoeff(q))) {
-        return false;
+/**
+ * Zwraca największy klucz jednomianu wielomianu, czyli klucz jednomianu
+ * leżącego na skrajnie prawej ścieżce drzewa.
+ * @param[in] p : wielomian
+ * @param[in] packing : upakowanie wykładników
+ * @return największy klucz
+ */
+static uint64_t PolyLastKey(const Poly *p, const KroneckerPacking* packing) {
+    uint64_t key = 0;
+    for (size_t level = 0; !PolyIsCoeff(p); level++) {
+        key += (uint64_t) p->arr[p->size - 1].exp * packing->strides[level];
+        p = &(p->arr[p->size - 1].p);
     }
+    return key;
+}
+
+/**
+ * Sprawdza, czy wielomian jest gęsty na najwyższym poziomie, czyli czy
+ * jednomiany zajmują co najmniej połowę wykładników od najmniejszego
+ * do największego.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy wielomian jest gęsty?
+ */
+static bool IsDenseLevel(const Poly *p) {
+    size_t len = (size_t) (p->arr[p->size - 1].exp - p->arr[0].exp) + 1;
+    return 2 * p->size >= len;
+}
+
+/**
+ * Zlicza wykładniki występujące na najwyższym poziomie w co najmniej jednym
+ * z dwóch wielomianów, czyli liczbę jednomianów ich sumy bez skracania.
+ * Współczynnik traktujemy jak jednomian o wykładniku zero.
+ * @param[in] p, q : wielomiany
+ * @return liczba jednomianów sumy
+ */
+static size_t UnionSize(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        return p->coeff == q->coeff;
+        return 1;
     }
-    if (p->size != q->size) {
-        return false;
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        const Poly *r = PolyIsCoeff(p) ? q : p;
+        return r->size + (r->arr[0].exp != 0 ? 1 : 0);
     }
 
-    size_t numberOfX = p->size;
-    for (size_t i = 0; i < numberOfX; i++) {
-        if (p->arr[i].exp != q->arr[i].exp) {
-            return false;
+    size_t i = 0, j = 0, count = 0;
+    while (i < p->size && j < q->size) {
+        if (p->arr[i].exp <= q->arr[j].exp) {
+            j += (p->arr[i].exp == q->arr[j].exp) ? 1 : 0;
+            i++;
         }
-    }
-    for (size_t i = 0; i < numberOfX; i++) {
-        if (!PolyIsEq(&(p->arr[i].p), &(q->arr[i].p))) {
-            return false;
+        else {
+            j++;
         }
+        count++;
     }
-    return true;
+    return count + (p->size - i) + (q->size - j);
 }
 
 /**
- * Mnoży wielomian przez współczynnik.
- * @param[in] p : wielomian @f$p@f$
- * @param[in] c : współczynnik przez który mnożymy
- * @return @f$c * q@f$
+ * Sprawdza, czy współczynniki wielomianu mają wspólny nośnik, czyli czy
+ * sumowanie współczynników z dolnej i górnej połowy nie powiększa ich
+ * istotnie. Tylko wtedy algorytm Karatsuby zyskuje na zastąpieniu mnożenia
+ * dodawaniami.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy współczynniki mają wspólny nośnik?
  */
-static Poly PolyMulByCoeff(const Poly *p, poly_coeff_t c) {
-    if (c == 0) {
-        return PolyZero();
+static bool HasSharedSupport(const Poly *p) {
+    size_t half = p->size / 2;
+    size_t unionTotal = 0, maxTotal = 0;
+    for (size_t i = 0; i < half; i++) {
+        const Poly *a = &(p->arr[i].p);
+        const Poly *b = &(p->arr[i + half].p);
+        size_t sizeA = PolyIsCoeff(a) ? 1 : a->size;
+        size_t sizeB = PolyIsCoeff(b) ? 1 : b->size;
+        unionTotal += UnionSize(a, b);
+        maxTotal += sizeA > sizeB ? sizeA : sizeB;
     }
-    if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->coeff * c);
-    } else {
-        Poly result = PolyOfSizeN(p->size);
-        poly_coeff_t indResult = 0;
+    return 2 * unionTotal <= 3 * maxTotal;
+}
 
-        for (size_t i = 0; i < p->size; i++) {
-            Poly partialResult = PolyMulByCoeff(&(p->arr[i].p), c);
-            if (!PolyIsZero(&partialResult)) {
-                result.arr[indResult] = MonoFromPoly(&partialResult, p->arr[i].exp);
-                indResult++;
+/**
+ * Sprawdza, czy iloczyn opłaca się liczyć algorytmem Karatsuby: oba czynniki
+ * muszą być gęste na najwyższym poziomie, mieć co najmniej
+ * KARATSUBA_MIN_TERMS jednomianów, nie różnić się długością więcej niż
+ * dwukrotnie i mieć współczynniki o wspólnym nośniku.
+ * @param[in] p, q : wielomiany niebędące współczynnikami
+ * @return Czy użyć algorytmu Karatsuby?
+ */
+static bool IsKaratsubaWorthwhile(const Poly *p, const Poly *q) {
+    if (p->size < KARATSUBA_MIN_TERMS || q->size < KARATSUBA_MIN_TERMS) {
+        return false;
+    }
+    if (2 * p->size < q->size || 2 * q->size < p->size) {
+        return false;
+    }
+    return IsDenseLevel(p) && IsDenseLevel(q)
+           && HasSharedSupport(p) && HasSharedSupport(q);
+}
+
+/**
+ * Mnoży szkolnie dwie tablice współczynników równej długości.
+ * @param[in] a, b : tablice @p n współczynników
+ * @param[in] n : długość tablic
+ * @param[out] result : tablica na @f$2n - 1@f$ współczynników iloczynu
+ */
+static void SchoolbookMulArr(const Poly* a, const Poly* b, size_t n, Poly* result) {
+    for (size_t k = 0; k < 2 * n - 1; k++) {
+        result[k] = PolyZero();
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (PolyIsZero(&a[i])) {
+            continue;
+        }
+        for (size_t j = 0; j < n; j++) {
+            if (PolyIsZero(&b[j])) {
+                continue;
             }
+            PolyAddMulTo(&result[i + j], &a[i], &b[j]);
         }
+    }
+}
 
-        if (indResult == 0) {
-            free(result.arr);
-            return PolyZero();
-        } else {
-            result.size = indResult;
-            return result;
-        }
+/**
+ * Dodaje do siebie dwie tablice współczynników, z których pierwsza może
+ * być krótsza (brakujące współczynniki są zerami).
+ * @param[in] a : tablica @p lenA współczynników
+ * @param[in] lenA : długość pierwszej tablicy
+ * @param[in] b : tablica @p n współczynników
+ * @param[in] n : długość drugiej tablicy i wyniku
+ * @param[out] result : tablica na @p n współczynników sumy
+ */
+static void AddArr(const Poly* a, size_t lenA, const Poly* b, size_t n, Poly* result) {
+    for (size_t i = 0; i < n; i++) {
+        result[i] = i < lenA ? PolyAdd(&a[i], &b[i]) : PolyClone(&b[i]);
     }
 }
 
-Poly PolyAt(const Poly *p, poly_coeff_t x) {
-    if (PolyIsCoeff(p)) {
-        return PolyClone(p);
+/**
+ * Usuwa z pamięci tablicę współczynników.
+ * @param[out] arr : tablica współczynników
+ * @param[in] n : długość tablicy
+ */
+static void PolyArrDestroy(Poly* arr, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        PolyDestroy(&arr[i]);
     }
+    PolyFree(arr);
+}
 
-    Poly result = PolyZero();
-    for (size_t i = 0; i < p->size; i++) {
-        poly_coeff_t mulBy = Exponentiation(x, p->arr[i].exp);
-        Poly partialResult = PolyMulByCoeff(&(p->arr[i].p), mulBy);
+/**
+ * Alokuje tablicę współczynników.
+ * @param[in] n : długość tablicy
+ * @return tablica
+ */
+static Poly* PolyArrAlloc(size_t n) {
+    Poly* arr = PolyMalloc(n * sizeof(Poly));
+    return arr;
+}
 
-        Poly result2 = PolyAdd(&result, &partialResult);
-        PolyDestroy(&result);
-        result = PolyClone(&result2);
-        PolyDestroy(&result2);
+/**
+ * Mnoży algorytmem Karatsuby dwie tablice współczynników równej długości.
+ * Współczynniki są dowolnymi wielomianami, mnożonymi za pomocą PolyMul,
+ * więc kolejne poziomy drzewa dobierają swój algorytm niezależnie.
+ * Dla @f$a = a_0 + a_1 x^m@f$ i @f$b = b_0 + b_1 x^m@f$ wynik to
+ * @f$a_0 b_0 + ((a_0 + a_1)(b_0 + b_1) - a_0 b_0 - a_1 b_1) x^m + a_1 b_1 x^{2m}@f$.
+ * @param[in] a, b : tablice @p n współczynników
+ * @param[in] n : długość tablic
+ * @param[out] result : tablica na @f$2n - 1@f$ współczynników iloczynu
+ */
+static void KaratsubaMulArr(const Poly* a, const Poly* b, size_t n, Poly* result) {
+    if (n < KARATSUBA_BASE_TERMS) {
+        SchoolbookMulArr(a, b, n, result);
+        return;
+    }
 
-        PolyDestroy(&partialResult);
+    // Dolne połowy mają m współczynników, górne high >= m.
+    size_t m = n / 2;
+    size_t high = n - m;
+
+    Poly* low = PolyArrAlloc(2 * m - 1);
+    KaratsubaMulArr(a, b, m, low);
+    Poly* top = PolyArrAlloc(2 * high - 1);
+    KaratsubaMulArr(a + m, b + m, high, top);
+
+    Poly* sumA = PolyArrAlloc(high);
+    Poly* sumB = PolyArrAlloc(high);
+    AddArr(a, m, a + m, high, sumA);
+    AddArr(b, m, b + m, high, sumB);
+    Poly* middle = PolyArrAlloc(2 * high - 1);
+    KaratsubaMulArr(sumA, sumB, high, middle);
+    PolyArrDestroy(sumA, high);
+    PolyArrDestroy(sumB, high);
+
+    // Wynik składamy w miejscu: środkowe iloczyny pomniejszamy o skrajne,
+    // a następnie wszystkie trzy przesuwamy na właściwe pozycje.
+    for (size_t k = 0; k < 2 * n - 1; k++) {
+        result[k] = PolyZero();
+    }
+    for (size_t k = 0; k < 2 * high - 1; k++) {
+        Poly negTop = PolyNeg(&top[k]);
+        PolyAddTo(&middle[k], &negTop);
+        if (k < 2 * m - 1) {
+            Poly negLow = PolyNeg(&low[k]);
+            PolyAddTo(&middle[k], &negLow);
+        }
+        result[k + m] = middle[k];
+    }
+    for (size_t k = 0; k < 2 * m - 1; k++) {
+        PolyAddTo(&result[k], &low[k]);
+    }
+    for (size_t k = 0; k < 2 * high - 1; k++) {
+        PolyAddTo(&result[k + 2 * m], &top[k]);
     }
 
-    return result;
+    PolyFree(low);
+    PolyFree(middle);
+    PolyFree(top);
 }
 
 /**
- * Funkcja pomocnicza mnożąca dwa wielomiany które nie
- * są współczynnikami.
- * @param[in] poly1 : wielomian @f$p@f$
- * @param[in] poly2 : wielomian @f$q@f$
- * @param[in] result : zwracany wynik
- * @return @f$p * q@f$
+ * Rozpakowuje najwyższy poziom wielomianu do gęstej tablicy płytkich kopii
+ * współczynników, w której brakujące jednomiany są zerami.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] n : długość tablicy, nie mniejsza niż rozpiętość wykładników @p p
+ * @return tablica, na pozycji @f$i@f$ współczynnik przy @f$x^{e + i}@f$,
+ * gdzie @f$e@f$ to najmniejszy wykładnik @p p
  */
-static Poly MulTwoPolys(const Poly *poly1, const Poly *poly2, Poly *result) {
-    for (size_t i = 0; i < poly1->size; i++) {
-        for (size_t j = 0; j < poly2->size; j++) {
-            Poly singlePolyCoeff = PolyMul(&(poly1->arr[i].p), &(poly2->arr[j].p));
-            poly_exp_t newExp = poly1->arr[i].exp + poly2->arr[j].exp;
-
-            Poly singlePoly;
-            if (PolyIsCoeff(poly1) && PolyIsCoeff(poly2)) {
-                singlePoly = PolyFromCoeff(singlePolyCoeff.coeff);
-            } else {
-                singlePoly.arr = malloc(sizeof(Mono));
-                if (singlePoly.arr == NULL) {
-                    exit(1);
-                }
-                singlePoly.size = 1;
-                singlePoly.arr[0] = MonoFromPoly(&singlePolyCoeff, newExp);
-            }
+static Poly* PolyToDenseArr(const Poly *p, size_t n) {
+    Poly* dense = PolyArrAlloc(n);
+    for (size_t i = 0; i < n; i++) {
+        dense[i] = PolyZero();
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        dense[p->arr[i].exp - p->arr[0].exp] = p->arr[i].p;
+    }
+    return dense;
+}
 
-            Poly resultHelp = PolyAdd(result, &singlePoly);
-            PolyDestroy(result);
-            PolyDestroy(&singlePoly);
-            *result = PolyClone(&resultHelp);
-            PolyDestroy(&resultHelp);
+/**
+ * Mnoży dwa wielomiany gęste na najwyższym poziomie algorytmem Karatsuby.
+ * @param[in] p, q : wielomiany niebędące współczynnikami
+ * @return @f$p * q@f$
+ */
+static Poly MulKaratsuba(const Poly *p, const Poly *q) {
+    size_t lenP = (size_t) (p->arr[p->size - 1].exp - p->arr[0].exp) + 1;
+    size_t lenQ = (size_t) (q->arr[q->size - 1].exp - q->arr[0].exp) + 1;
+    size_t n = lenP > lenQ ? lenP : lenQ;
+
+    // Tablice przechowują płytkie kopie, więc zwalniamy tylko je same.
+    Poly* denseP = PolyToDenseArr(p, n);
+    Poly* denseQ = PolyToDenseArr(q, n);
+    Poly* product = PolyArrAlloc(2 * n - 1);
+    KaratsubaMulArr(denseP, denseQ, n, product);
+    PolyFree(denseP);
+    PolyFree(denseQ);
+
+    poly_exp_t shift = p->arr[0].exp + q->arr[0].exp;
+    Poly result = PolyOfSizeN(2 * n - 1);
+    result.size = 0;
+    for (size_t k = 0; k < 2 * n - 1; k++) {
+        if (PolyIsZero(&product[k])) {
+            continue;
         }
+        result.arr[result.size] = MonoFromPoly(&product[k], shift + (poly_exp_t) k);
+        (result.size)++;
     }
-    return *result;
+    PolyFree(product);
+
+    return PolyNormalize(result);
 }
 
 Poly PolyMul(const Poly *p, const Poly *q) {
@@ -665,10 +2425,114 @@ Poly PolyMul(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(q)) {
         return PolyMulByCoeff(p, q->coeff);
     }
+    // Czynniki o wspólnej tablicy jednomianów, np. po CLONE, są równe.
+    if (p->arr == q->arr) {
+        return PolySqr(p);
+    }
 
-    Poly result = PolyZero();
-    MulTwoPolys(p, q, &result);
-    return result;
+    // Gęste po upakowaniu wykładników czynniki mnożymy za pomocą NTT,
+    // gęste na najwyższym poziomie algorytmem Karatsuby, a pozostałe
+    // scalaniem kopcem (po upakowaniu wykładników, jeśli to możliwe).
+    KroneckerPacking packing;
+    bool packed = KroneckerPackingCreate(p, q, &packing);
+    if (packed && IsNttWorthwhile(PolyLeafCount(p), PolyLastKey(p, &packing) + 1,
+                                  PolyLeafCount(q), PolyLastKey(q, &packing) + 1)) {
+        Poly result = MulByKronecker(p, q, &packing);
+        KroneckerPackingDestroy(&packing);
+        return result;
+    }
+    if (IsKaratsubaWorthwhile(p, q)) {
+        if (packed) {
+            KroneckerPackingDestroy(&packing);
+        }
+        return MulKaratsuba(p, q);
+    }
+    if (packed) {
+        Poly result = MulByKronecker(p, q, &packing);
+        KroneckerPackingDestroy(&packing);
+        return result;
+    }
+    return MulTwoPolys(p, q);
+}
+
+/**
+ * Funkcja pomocnicza podnosząca do kwadratu wielomian niebędący
+ * współczynnikiem, tak jak MulTwoPolys, ale tylko z ciągów
+ * @f$p_i p_i, p_i p_{i+1}, \ldots@f$. Iloczyny różnych jednomianów
+ * o równych wykładnikach są sumowane osobno i podwajane raz, a kwadraty
+ * współczynników liczone rekurencyjnie przez PolySqr.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p^2@f$
+ */
+static Poly SqrMonos(const Poly *p) {
+    MulHeap heap = MulHeapCreate(p->size);
+    size_t capacity = 2 * p->size;
+    Poly result = PolyOfSizeN(capacity);
+    result.size = 0;
+
+    MulHeapPush(&heap, p->arr[0].exp + p->arr[0].exp, 0, 0);
+    while (heap.size > 0) {
+        poly_exp_t exp = heap.arr[0].key;
+        Poly squares = PolyZero();
+        Poly products = PolyZero();
+
+        while (heap.size > 0 && heap.arr[0].key == (uint64_t) exp) {
+            MulHeapItem item = MulHeapPop(&heap);
+            size_t i = item.i;
+            size_t j = item.j;
+
+            if (i == j) {
+                Poly square = PolySqr(&(p->arr[i].p));
+                PolyAddTo(&squares, &square);
+                if (i + 1 < p->size) {
+                    MulHeapPush(&heap, p->arr[i + 1].exp + p->arr[i + 1].exp, i + 1, i + 1);
+                }
+            } else {
+                PolyAddMulTo(&products, &(p->arr[i].p), &(p->arr[j].p));
+            }
+            if (j + 1 < p->size) {
+                MulHeapPush(&heap, p->arr[i].exp + p->arr[j + 1].exp, i, j + 1);
+            }
+        }
+
+        Poly doubled = PolyMulByCoeff(&products, 2);
+        PolyDestroy(&products);
+        PolyAddTo(&squares, &doubled);
+        if (!PolyIsZero(&squares)) {
+            AppendMono(&result, &capacity, MonoFromPoly(&squares, exp));
+        }
+    }
+    PolyFree(heap.arr);
+
+    return PolyNormalize(result);
+}
+
+Poly PolySqr(const Poly *p) {
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffMul(p->coeff, p->coeff));
+    }
+
+    // Algorytm wybieramy tak jak w PolyMul.
+    KroneckerPacking packing;
+    bool packed = KroneckerPackingCreate(p, p, &packing);
+    if (packed && IsNttWorthwhile(PolyLeafCount(p), PolyLastKey(p, &packing) + 1,
+                                  PolyLeafCount(p), PolyLastKey(p, &packing) + 1)) {
+        Poly result = MulByKronecker(p, p, &packing);
+        KroneckerPackingDestroy(&packing);
+        return result;
+    }
+    if (IsKaratsubaWorthwhile(p, p)) {
+        if (packed) {
+            KroneckerPackingDestroy(&packing);
+        }
+        return MulKaratsuba(p, p);
+    }
+    if (packed) {
+        Poly result = MulByKronecker(p, p, &packing);
+        KroneckerPackingDestroy(&packing);
+        return result;
+    }
+    return SqrMonos(p);
 }
 
 /**
@@ -688,7 +2552,7 @@ static Poly PolyExpBySquaring(const Poly* basis, poly_exp_t exp) {
         return PolyFromCoeff(Exponentiation(basis->coeff, exp));
     }
     Poly sqrtResult = PolyExpBySquaring(basis, exp / 2);
-    Poly result = PolyMul(&sqrtResult, &sqrtResult);
+    Poly result = PolySqr(&sqrtResult);
 
     if (exp % 2 == 1) {
         Poly partialResult = PolyMul(&result, basis);
@@ -700,46 +2564,290 @@ static Poly PolyExpBySquaring(const Poly* basis, poly_exp_t exp) {
     return result;
 }
 
+/**
+ * Potęgi wielomianu podstawianego pod jedną zmienną, potrzebne przy
+ * składaniu. Wykładniki są posortowane rosnąco i nie powtarzają się.
+ */
+typedef struct ComposePowers {
+    poly_exp_t* exps; ///< wykładniki
+    Poly* powers; ///< powers[i] to podstawiany wielomian do potęgi exps[i]
+    size_t size; ///< liczba potęg
+    size_t capacity; ///< pojemność tablic
+} ComposePowers;
+
+/**
+ * Porównuje wykładniki, funkcja pomocnicza do qsort.
+ * @param[in] a : pierwszy wykładnik
+ * @param[in] b : drugi wykładnik
+ * @return liczba ujemna, zero lub dodatnia, gdy @p a jest odpowiednio
+ *         mniejszy, równy lub większy od @p b
+ */
+static int CompareExps(const void* a, const void* b) {
+    poly_exp_t x = *(const poly_exp_t*) a;
+    poly_exp_t y = *(const poly_exp_t*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Zbiera dodatnie wykładniki, w których występują zmienne
+ * @f$x_0, \ldots, x_{k-1}@f$ wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba zmiennych, pod które podstawiamy wielomiany
+ * @param[in, out] tables : potęgi dla kolejnych zmiennych
+ * @param[in] level : indeks zmiennej wielomianu @p p
+ */
+static void CollectComposeExps(const Poly *p, size_t k, ComposePowers* tables, size_t level) {
+    if (PolyIsCoeff(p) || level >= k) {
+        return;
+    }
+    ComposePowers* table = &(tables[level]);
+    for (size_t i = 0; i < p->size; i++) {
+        if (p->arr[i].exp > 0) {
+            if (table->size == table->capacity) {
+                table->capacity = table->capacity == 0 ? p->size : 2 * table->capacity;
+                table->exps = PolyRealloc(table->exps, table->capacity * sizeof(poly_exp_t));
+            }
+            table->exps[(table->size)++] = p->arr[i].exp;
+        }
+        CollectComposeExps(&(p->arr[i].p), k, tables, level + 1);
+    }
+}
+
+/**
+ * Wyszukuje potęgę w tablicy potęg.
+ * @param[in] table : potęgi
+ * @param[in] count : liczba przeszukiwanych początkowych potęg
+ * @param[in] exp : wykładnik
+ * @return wskaźnik na potęgę lub NULL, jeśli jej nie ma
+ */
+static const Poly* FindComposePower(const ComposePowers* table, size_t count, poly_exp_t exp) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table->exps[mid] < exp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count && table->exps[lo] == exp ? &(table->powers[lo]) : NULL;
+}
+
+/**
+ * Sortuje wykładniki, usuwa powtórzenia i liczy potęgi podstawianego
+ * wielomianu. Każdą potęgę liczymy z najbliższej mniejszej, mnożąc ją
+ * przez potęgę o wykładniku równym różnicy. Ta z kolei jest brana
+ * z tablicy, jeśli już w niej jest, więc dla gęstych wykładników każda
+ * potęga kosztuje jedno mnożenie.
+ * @param[in, out] table : potęgi
+ * @param[in] q : podstawiany wielomian
+ */
+static void ComputeComposePowers(ComposePowers* table, const Poly *q) {
+    if (table->size == 0) {
+        return;
+    }
+    qsort(table->exps, table->size, sizeof(poly_exp_t), CompareExps);
+    size_t unique = 1;
+    for (size_t i = 1; i < table->size; i++) {
+        if (table->exps[i] != table->exps[unique - 1]) {
+            table->exps[unique++] = table->exps[i];
+        }
+    }
+    table->size = unique;
+
+    table->powers = PolyMalloc(table->size * sizeof(Poly));
+    table->powers[0] = PolyExpBySquaring(q, table->exps[0]);
+    for (size_t i = 1; i < table->size; i++) {
+        poly_exp_t gap = table->exps[i] - table->exps[i - 1];
+        const Poly* gapPower = gap == 1 ? q : FindComposePower(table, i, gap);
+        if (gapPower != NULL) {
+            table->powers[i] = PolyMul(&(table->powers[i - 1]), gapPower);
+        } else {
+            Poly computed = PolyExpBySquaring(q, gap);
+            table->powers[i] = PolyMul(&(table->powers[i - 1]), &computed);
+            PolyDestroy(&computed);
+        }
+    }
+}
+
 /**
  * Rekurencyjna funkcja pomocnicza obliczająca wynik operacji podstawiania k wielomianów
  * z tablicy q pod zmienne danego wielomianu p,
  * zależnie od aktualnego poziomu zagnieżdżenia rekurencji.
  * @param[in] p : wielomian @f$p(x_0, x_1, \ldots, x_{l-1})@f$
  * @param[in] k : liczba wielomianów podstawianych pod zmienne
- * @param[in] q : tablica wielomianów które zostaną podstawione
+ * @param[in] tables : potęgi podstawianych wielomianów
  * @param[in, out] recurrenceLevel : aktualny poziom zagnieżdżenia rekurencji
  * @return @f$p(q_0, q_1, \ldots)@f$
  * */
-static Poly PolyComposeHelper(const Poly *p, size_t k, const Poly q[], size_t recurrenceLevel) {
+static Poly PolyComposeHelper(const Poly *p, size_t k, const ComposePowers* tables,
+                              size_t recurrenceLevel) {
     if (PolyIsCoeff(p)) {
         return PolyClone(p);
     }
 
     Poly result = PolyZero();
     for (size_t i = 0; i < p->size; i++) {
-        Poly composedCoeff = PolyComposeHelper(&(p->arr[i].p), k, q, recurrenceLevel + 1);
-        Poly substitutedVar;
-        if (recurrenceLevel >= k) {
-            Poly polyZero = PolyZero();
-            substitutedVar = PolyExpBySquaring(&polyZero, p->arr[i].exp);
-            PolyDestroy(&polyZero);
+        poly_exp_t exp = p->arr[i].exp;
+        if (recurrenceLevel >= k && exp > 0) {
+            // Pod zmienną podstawiamy zero, więc jednomian się zeruje.
+            continue;
+        }
+        Poly composedCoeff = PolyComposeHelper(&(p->arr[i].p), k, tables, recurrenceLevel + 1);
+        if (exp == 0) {
+            PolyAddTo(&result, &composedCoeff);
         } else {
-            substitutedVar = PolyExpBySquaring(&(q[recurrenceLevel]), p->arr[i].exp);
+            const ComposePowers* table = &(tables[recurrenceLevel]);
+            PolyAddMulTo(&result, &composedCoeff, FindComposePower(table, table->size, exp));
+            PolyDestroy(&composedCoeff);
         }
+    }
+    return result;
+}
 
-        Poly composedMono = PolyMul(&composedCoeff, &substitutedVar);
-        PolyDestroy(&composedCoeff);
-        PolyDestroy(&substitutedVar);
+/**
+ * Składa wielomian jednej zmiennej o stałych współczynnikach z wielomianem
+ * @p q rzadkim schematem Hornera:
+ * @f$(\ldots(c_{n} q^{e_n - e_{n-1}} + c_{n-1}) q^{e_{n-1} - e_{n-2}} + \ldots) q^{e_0}@f$.
+ * Potęgi @p q o wykładnikach równych różnicom są liczone raz.
+ * @param[in] p : wielomian o stałych współczynnikach
+ * @param[in] q : wielomian podstawiany pod zmienną
+ * @return @f$p(q)@f$
+ */
+static Poly ComposeHorner(const Poly *p, const Poly *q) {
+    ComposePowers gaps = {.exps = NULL, .powers = NULL, .size = 0, .capacity = p->size};
+    gaps.exps = PolyMalloc(gaps.capacity * sizeof(poly_exp_t));
+    for (size_t i = 0; i < p->size; i++) {
+        poly_exp_t gap = p->arr[i].exp - (i > 0 ? p->arr[i - 1].exp : 0);
+        if (gap > 0) {
+            gaps.exps[(gaps.size)++] = gap;
+        }
+    }
+    ComputeComposePowers(&gaps, q);
+
+    Poly acc = PolyZero();
+    for (size_t i = p->size; i-- > 0;) {
+        Poly c = PolyFromCoeff(p->arr[i].p.coeff);
+        PolyAddTo(&acc, &c);
+        poly_exp_t gap = p->arr[i].exp - (i > 0 ? p->arr[i - 1].exp : 0);
+        if (gap > 0) {
+            Poly product = PolyMul(&acc, FindComposePower(&gaps, gaps.size, gap));
+            PolyDestroy(&acc);
+            acc = product;
+        }
+    }
 
-        Poly partialResult = PolyAdd(&result, &composedMono);
-        PolyDestroy(&result);
-        result = partialResult;
+    for (size_t i = 0; i < gaps.size; i++) {
+        PolyDestroy(&(gaps.powers[i]));
+    }
+    PolyFree(gaps.powers);
+    PolyFree(gaps.exps);
+    return acc;
+}
+
+/**
+ * Rekurencyjna funkcja pomocnicza do ComposeDivide. Jednomiany z przedziału
+ * mają wykładniki z przedziału @f$[base, base + 2^{level})@f$. Dzieli je na
+ * połowy @f$p_{low} + x^{h} p_{high}@f$, gdzie @f$h = 2^{level - 1}@f$,
+ * i zwraca @f$p_{low}(q) + q^{h} p_{high}(q)@f$, więc mnożone wielomiany
+ * mają podobne rozmiary.
+ * @param[in] p : wielomian o stałych współczynnikach
+ * @param[in] lo : początek przedziału jednomianów
+ * @param[in] hi : koniec przedziału jednomianów (bez niego)
+ * @param[in] base : najmniejszy możliwy wykładnik w przedziale
+ * @param[in] level : logarytm szerokości przedziału wykładników
+ * @param[in] squares : squares[j] to @f$q^{2^j}@f$
+ * @return @f$\sum_{lo \le i < hi} c_i q^{e_i - base}@f$
+ */
+static Poly ComposeDivideHelper(const Poly *p, size_t lo, size_t hi, int64_t base,
+                                size_t level, const Poly* squares) {
+    if (lo == hi) {
+        return PolyZero();
+    }
+    if (level == 0) {
+        return PolyFromCoeff(p->arr[lo].p.coeff);
+    }
+
+    int64_t half = (int64_t) 1 << (level - 1);
+    size_t mid = lo;
+    while (mid < hi && p->arr[mid].exp < base + half) {
+        mid++;
+    }
+
+    Poly low = ComposeDivideHelper(p, lo, mid, base, level - 1, squares);
+    if (mid < hi) {
+        Poly high = ComposeDivideHelper(p, mid, hi, base + half, level - 1, squares);
+        PolyAddMulTo(&low, &high, &(squares[level - 1]));
+        PolyDestroy(&high);
+    }
+    return low;
+}
+
+/**
+ * Składa wielomian jednej zmiennej o stałych współczynnikach z wielomianem
+ * @p q metodą dziel i zwyciężaj, korzystając tylko z potęg @f$q^{2^j}@f$.
+ * W przeciwieństwie do schematu Hornera mnożone wielomiany mają podobne
+ * rozmiary, więc PolyMul może użyć szybkich algorytmów mnożenia.
+ * @param[in] p : wielomian o stałych współczynnikach
+ * @param[in] q : wielomian podstawiany pod zmienną
+ * @return @f$p(q)@f$
+ */
+static Poly ComposeDivide(const Poly *p, const Poly *q) {
+    poly_exp_t maxExp = p->arr[p->size - 1].exp;
+    size_t levels = 0;
+    while (((int64_t) 1 << levels) <= maxExp) {
+        levels++;
+    }
 
-        PolyDestroy(&composedMono);
+    Poly* squares = PolyMalloc((levels > 0 ? levels : 1) * sizeof(Poly));
+    for (size_t j = 0; j < levels; j++) {
+        squares[j] = j == 0 ? PolyClone(q) : PolySqr(&(squares[j - 1]));
     }
+    Poly result = ComposeDivideHelper(p, 0, p->size, 0, levels, squares);
+    for (size_t j = 0; j < levels; j++) {
+        PolyDestroy(&(squares[j]));
+    }
+    PolyFree(squares);
     return result;
 }
 
 Poly PolyCompose(const Poly *p, size_t k, const Poly* q) {
-    return PolyComposeHelper(p, k, q, 0);
+    if (!PolyIsCoeff(p) && k > 0 && HasCoeffCoefficients(p)) {
+        if (PolyIsCoeff(&(q[0]))) {
+            return PolyFromCoeff(HornerAt(p, q[0].coeff));
+        }
+        if (p->size <= COMPOSE_HORNER_MAX_TERMS) {
+            return ComposeHorner(p, &(q[0]));
+        }
+        return ComposeDivide(p, &(q[0]));
+    }
+
+    // Potrzebujemy tylko potęg wielomianów podstawianych pod zmienne,
+    // które występują w wielomianie.
+    size_t levels = PolyVarCount(p);
+    if (levels > k) {
+        levels = k;
+    }
+
+    ComposePowers* tables = PolyMalloc((levels > 0 ? levels : 1) * sizeof(ComposePowers));
+    for (size_t i = 0; i < levels; i++) {
+        tables[i] = (ComposePowers) {.exps = NULL, .powers = NULL, .size = 0, .capacity = 0};
+    }
+    CollectComposeExps(p, levels, tables, 0);
+    for (size_t i = 0; i < levels; i++) {
+        ComputeComposePowers(&(tables[i]), &(q[i]));
+    }
+
+    Poly result = PolyComposeHelper(p, levels, tables, 0);
+
+    for (size_t i = 0; i < levels; i++) {
+        for (size_t j = 0; j < tables[i].size; j++) {
+            PolyDestroy(&(tables[i].powers[j]));
+        }
+        PolyFree(tables[i].powers);
+        PolyFree(tables[i].exps);
+    }
+    PolyFree(tables);
+    return result;
 }
\ No newline at end of file
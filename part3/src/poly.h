@@ -53,6 +53,18 @@ typedef struct Mono {
   poly_exp_t exp; ///< wykładnik
 } Mono;
 
+/**
+ * To jest struktura przechowująca jednomiany dodawane kolejno do
+ * tworzonego wielomianu. Tablica jednomianów rośnie geometrycznie i staje
+ * się tablicą wielomianu utworzonego przez PolyBuilderFinish.
+ */
+typedef struct PolyBuilder {
+  Mono *arr; ///< dodane jednomiany
+  size_t size; ///< liczba dodanych jednomianów
+  size_t capacity; ///< pojemność tablicy jednomianów
+  bool sorted; ///< czy wykładniki dodanych jednomianów rosną
+} PolyBuilder;
+
 /**
  * Daje wartość wykładnika jendomianu.
  * @param[in] m : jednomian
@@ -138,6 +150,29 @@ static inline Mono MonoClone(const Mono *m) {
   return (Mono) {.p = PolyClone(&m->p), .exp = m->exp};
 }
 
+/**
+ * Zastępuje wielomian jego unikalnym egzemplarzem: wszystkie równe
+ * poddrzewa wielomianów przekazanych do tej funkcji są przechowywane
+ * w pamięci tylko raz, a równość dwóch unikalnych wielomianów sprowadza się
+ * do porównania wskaźników. Przejmuje na własność wielomian @p p.
+ * @param[in] p : wielomian
+ * @return unikalny wielomian równy @p p
+ */
+Poly PolyIntern(Poly p);
+
+/**
+ * Włącza lub wyłącza tryb, w którym wielomiany wstawiane na stos
+ * kalkulatora są zastępowane unikalnymi egzemplarzami (PolyIntern).
+ * @param[in] enabled : czy tryb ma być włączony
+ */
+void PolySetInterning(bool enabled);
+
+/**
+ * Sprawdza, czy włączony jest tryb unikalnych wielomianów.
+ * @return Czy tryb jest włączony?
+ */
+bool PolyIsInterning(void);
+
 /**
  * Dodaje dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -146,6 +181,32 @@ static inline Mono MonoClone(const Mono *m) {
  */
 Poly PolyAdd(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje wielomian do akumulatora w miejscu. Wykorzystuje ponownie tablicę
+ * jednomianów akumulatora i przejmuje na własność zawartość wielomianu
+ * @p consumed, który po wykonaniu funkcji jest tożsamościowo równy zeru.
+ * @param[in, out] acc : akumulator @f$p@f$, po wykonaniu @f$p + q@f$
+ * @param[in, out] consumed : wielomian @f$q@f$
+ */
+void PolyAddTo(Poly *acc, Poly *consumed);
+
+/**
+ * Dodaje iloczyn dwóch wielomianów do akumulatora w miejscu.
+ * @param[in, out] acc : akumulator @f$r@f$, po wykonaniu @f$r + p * q@f$
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ */
+void PolyAddMulTo(Poly *acc, const Poly *p, const Poly *q);
+
+/**
+ * Odejmuje wielomian od akumulatora w miejscu. Zamiast tworzyć wielomian
+ * przeciwny, neguje współczynniki wielomianu @p consumed w jego własnych
+ * tablicach i przejmuje go na własność, tak jak PolyAddTo.
+ * @param[in, out] acc : akumulator @f$p@f$, po wykonaniu @f$p - q@f$
+ * @param[in, out] consumed : wielomian @f$q@f$
+ */
+void PolySubTo(Poly *acc, Poly *consumed);
+
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
  * pamięć wskazywaną przez @p monos i jej zawartość. Może dowolnie modyfikować
@@ -178,6 +239,37 @@ Poly PolyCloneMonos(size_t count, const Mono* monos);
  */
 Poly PolyAddMonos(size_t count, const Mono* monos);
 
+/**
+ * Tworzy pusty budowniczy wielomianu.
+ * @param[in] capacity : spodziewana liczba jednomianów, może być zerem
+ * @return budowniczy wielomianu
+ */
+PolyBuilder PolyBuilderCreate(size_t capacity);
+
+/**
+ * Dodaje jednomian do budowanego wielomianu. Przejmuje na własność
+ * zawartość jednomianu @p m. Jednomiany mogą przychodzić w dowolnej
+ * kolejności i powtarzać wykładniki, ale jeśli ich wykładniki rosną,
+ * PolyBuilderFinish nie sortuje ich ani nie scala.
+ * @param[in, out] builder : budowniczy wielomianu
+ * @param[in] m : jednomian
+ */
+void PolyBuilderAppend(PolyBuilder *builder, Mono *m);
+
+/**
+ * Tworzy wielomian będący sumą dodanych jednomianów, bez kopiowania ich
+ * tablicy. Budowniczy jest potem pusty i można go używać ponownie.
+ * @param[in, out] builder : budowniczy wielomianu
+ * @return wielomian będący sumą jednomianów
+ */
+Poly PolyBuilderFinish(PolyBuilder *builder);
+
+/**
+ * Usuwa z pamięci budowniczego razem z dodanymi jednomianami.
+ * @param[in, out] builder : budowniczy wielomianu
+ */
+void PolyBuilderDestroy(PolyBuilder *builder);
+
 /**
  * Mnoży dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -186,6 +278,15 @@ Poly PolyAddMonos(size_t count, const Mono* monos);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Podnosi wielomian do kwadratu. Każdy iloczyn dwóch różnych jednomianów
+ * liczony jest raz i podwajany, a współczynniki będące wielomianami
+ * podnoszone są do kwadratu rekurencyjnie.
+ * @param[in] p : wielomian @f$p@f$
+ * @return @f$p^2@f$
+ */
+Poly PolySqr(const Poly *p);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -220,6 +321,14 @@ poly_exp_t PolyDegBy(const Poly *p, size_t varIdx);
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zwraca liczbę jednomianów wielomianu po rozwinięciu go do sumy
+ * jednomianów wielu zmiennych (0 dla wielomianu tożsamościowo równego zeru).
+ * @param[in] p : wielomian
+ * @return liczba jednomianów wielomianu @p p
+ */
+size_t PolyTermCount(const Poly *p);
+
 /**
  * Sprawdza równość dwóch wielomianów.
  * @param[in] p : wielomian @f$p@f$
@@ -241,6 +350,20 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartości wielomianu w @p n punktach, tak jak PolyAt dla każdego
+ * z nich. Dla dużych wielomianów jednej zmiennej o stałych współczynnikach
+ * wartości liczone są naraz za pomocą drzewa iloczynów i drzewa reszt,
+ * a w pozostałych przypadkach tablica jednomianów przechodzona jest raz
+ * dla wielu punktów naraz.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : liczba punktów
+ * @param[in] xs : tablica punktów @f$x_0, x_1, \ldots, x_{n-1}@f$
+ * @param[out] results : tablica na @p n wyników, @f$i@f$-ty to
+ *                       @f$p(x_i, \ldots)@f$
+ */
+void PolyAtMany(const Poly *p, size_t n, const poly_coeff_t *xs, Poly *results);
+
 /**
  * Pod l zmiennych wielomianu p, oznaczonych jako @f$x_0@f$, @f$x_1@f$, ..., @f$x_{l-1}@f$,
  * podstawia @p k kolejnych wielomianów z tablicy q,
@@ -0,0 +1,222 @@
+/** @file
+ *  Implementacja alokatora pamięci z listami wolnych bloków
+ *  dla klas rozmiarów będących potęgami dwójki.
+ *  @author Patrycja Stępień
+*/
+
+#include "poly_alloc.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Wykładnik potęgi dwójki będącej wielkością najmniejszej klasy bloków.
+ */
+#define POOL_MIN_SHIFT 4
+
+/**
+ * Wykładnik potęgi dwójki będącej wielkością największej klasy bloków.
+ * Większe bloki przydzielane są bezpośrednio przez malloc.
+ */
+#define POOL_MAX_SHIFT 20
+
+/**
+ * Liczba klas bloków obsługiwanych przez listy wolnych bloków.
+ */
+#define POOL_CLASSES (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+
+/**
+ * Klasa bloków przydzielanych bezpośrednio przez malloc.
+ */
+#define POOL_LARGE_CLASS ((size_t) POOL_CLASSES)
+
+/**
+ * Maksymalna łączna wielkość wolnych bloków jednej klasy przechowywanych
+ * na liście. Nadmiarowe bloki są oddawane systemowi.
+ */
+#define POOL_MAX_CACHED_BYTES ((size_t) 1 << 22)
+
+/**
+ * Nagłówek poprzedzający każdy przydzielony blok. Ma 16 bajtów, więc
+ * zachowuje wyrównanie bloków zwracanych przez malloc.
+ */
+typedef struct BlockHeader {
+    uint16_t sizeClass; ///< klasa bloku
+    uint16_t interned; ///< czy blok jest w tablicy unikalnych wielomianów
+    uint32_t refCount; ///< liczba właścicieli bloku
+    void* meta; ///< dane zapamiętane dla zawartości bloku lub NULL
+} BlockHeader;
+
+/**
+ * Wolny blok na liście wolnych bloków swojej klasy.
+ */
+typedef struct FreeBlock {
+    BlockHeader header; ///< nagłówek bloku
+    struct FreeBlock* next; ///< następny wolny blok tej samej klasy
+} FreeBlock;
+
+/**
+ * Lista wolnych bloków jednej klasy.
+ */
+typedef struct FreeList {
+    FreeBlock* head; ///< pierwszy wolny blok
+    size_t count; ///< liczba wolnych bloków na liście
+} FreeList;
+
+/**
+ * Listy wolnych bloków bieżącego wątku, po jednej dla każdej klasy.
+ */
+static _Thread_local FreeList freeLists[POOL_CLASSES];
+
+/**
+ * Zwraca wielkość bloków zadanej klasy.
+ * @param[in] sizeClass : klasa bloków
+ * @return wielkość bloków w bajtach
+ */
+static size_t ClassBytes(size_t sizeClass) {
+    return (size_t) 1 << (sizeClass + POOL_MIN_SHIFT);
+}
+
+/**
+ * Wyznacza najmniejszą klasę, której bloki mieszczą zadaną liczbę bajtów.
+ * @param[in] size : wielkość bloku w bajtach
+ * @return klasa bloku
+ */
+static size_t SizeClass(size_t size) {
+#ifdef POLY_PLAIN_MALLOC
+    (void) size;
+    return POOL_LARGE_CLASS;
+#else
+    size_t sizeClass = 0;
+    while (sizeClass < POOL_CLASSES && ClassBytes(sizeClass) < size) {
+        sizeClass++;
+    }
+    return sizeClass;
+#endif
+}
+
+/**
+ * Przydziela za pomocą malloc blok z nagłówkiem.
+ * @param[in] size : wielkość bloku bez nagłówka
+ * @return nagłówek bloku
+ */
+static BlockHeader* RawAlloc(size_t size) {
+    BlockHeader* header = malloc(sizeof(BlockHeader) + size);
+    if (header == NULL) {
+        exit(1);
+    }
+    return header;
+}
+
+void* PolyMalloc(size_t size) {
+    size_t sizeClass = SizeClass(size);
+    BlockHeader* header;
+
+    if (sizeClass == POOL_LARGE_CLASS) {
+        header = RawAlloc(size);
+    } else if (freeLists[sizeClass].head != NULL) {
+        FreeBlock* block = freeLists[sizeClass].head;
+        freeLists[sizeClass].head = block->next;
+        (freeLists[sizeClass].count)--;
+        header = &(block->header);
+    } else {
+        header = RawAlloc(ClassBytes(sizeClass));
+    }
+
+    header->sizeClass = (uint16_t) sizeClass;
+    header->interned = 0;
+    header->refCount = 1;
+    header->meta = NULL;
+    return header + 1;
+}
+
+void* PolyRealloc(void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return PolyMalloc(size);
+    }
+
+    BlockHeader* header = (BlockHeader*) ptr - 1;
+    size_t sizeClass = header->sizeClass;
+    // Zawartość bloku zmienia się, więc zapamiętane dla niej dane są nieaktualne.
+    PolyBlockSetMeta(ptr, NULL);
+    if (sizeClass != POOL_LARGE_CLASS && size <= ClassBytes(sizeClass)) {
+        return ptr;
+    }
+    if (sizeClass == POOL_LARGE_CLASS && SizeClass(size) == POOL_LARGE_CLASS) {
+        header = realloc(header, sizeof(BlockHeader) + size);
+        if (header == NULL) {
+            exit(1);
+        }
+        return header + 1;
+    }
+
+    // Blok zmienia klasę, więc przenosimy zawartość do nowego bloku.
+    void* newPtr = PolyMalloc(size);
+    size_t oldSize = sizeClass == POOL_LARGE_CLASS ? size : ClassBytes(sizeClass);
+    memcpy(newPtr, ptr, oldSize < size ? oldSize : size);
+    PolyFree(ptr);
+    return newPtr;
+}
+
+void PolyFree(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    BlockHeader* header = (BlockHeader*) ptr - 1;
+    size_t sizeClass = header->sizeClass;
+    PolyFree(header->meta);
+    if (sizeClass == POOL_LARGE_CLASS ||
+        freeLists[sizeClass].count >= POOL_MAX_CACHED_BYTES / ClassBytes(sizeClass)) {
+        free(header);
+        return;
+    }
+
+    FreeBlock* block = (FreeBlock*) header;
+    block->next = freeLists[sizeClass].head;
+    freeLists[sizeClass].head = block;
+    (freeLists[sizeClass].count)++;
+}
+
+void PolyBlockRetain(void* ptr) {
+    ((BlockHeader*) ptr - 1)->refCount++;
+}
+
+bool PolyBlockRelease(void* ptr) {
+    BlockHeader* header = (BlockHeader*) ptr - 1;
+    return --(header->refCount) == 0;
+}
+
+bool PolyBlockIsShared(const void* ptr) {
+    return ((const BlockHeader*) ptr - 1)->refCount > 1;
+}
+
+void PolyBlockSetInterned(void* ptr) {
+    ((BlockHeader*) ptr - 1)->interned = 1;
+}
+
+bool PolyBlockIsInterned(const void* ptr) {
+    return ((const BlockHeader*) ptr - 1)->interned != 0;
+}
+
+void* PolyBlockMeta(const void* ptr) {
+    return ((const BlockHeader*) ptr - 1)->meta;
+}
+
+void PolyBlockSetMeta(void* ptr, void* meta) {
+    BlockHeader* header = (BlockHeader*) ptr - 1;
+    PolyFree(header->meta);
+    header->meta = meta;
+}
+
+void PolyAllocRelease(void) {
+    for (size_t i = 0; i < POOL_CLASSES; i++) {
+        while (freeLists[i].head != NULL) {
+            FreeBlock* block = freeLists[i].head;
+            freeLists[i].head = block->next;
+            free(block);
+        }
+        freeLists[i].count = 0;
+    }
+}
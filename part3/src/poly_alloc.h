@@ -0,0 +1,97 @@
+/** @file
+ *  Alokator pamięci dla tablic jednomianów i pozostałych struktur
+ *  pomocniczych wielomianów.
+ *  @author Patrycja Stępień
+*/
+
+#ifndef POLY_ALLOC_H
+#define POLY_ALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Alokuje blok pamięci zadanej wielkości. Bloki są pogrupowane w klasy
+ * rozmiarów będących potęgami dwójki, a zwolnione bloki trafiają na listy
+ * wolnych bloków bieżącego wątku, skąd są ponownie przydzielane bez
+ * odwoływania się do malloc. Po zdefiniowaniu POLY_PLAIN_MALLOC każde
+ * wywołanie trafia bezpośrednio do malloc.
+ * Kończy program kodem 1, jeśli zabraknie pamięci.
+ * @param[in] size : wielkość bloku w bajtach
+ * @return wskaźnik na blok
+ */
+void* PolyMalloc(size_t size);
+
+/**
+ * Zmienia wielkość bloku przydzielonego przez PolyMalloc, zachowując jego
+ * zawartość. Jeśli nowa wielkość mieści się w klasie bloku, zwraca ten sam
+ * blok. Blok nie może być współdzielony.
+ * Kończy program kodem 1, jeśli zabraknie pamięci.
+ * @param[in] ptr : blok lub NULL
+ * @param[in] size : nowa wielkość bloku w bajtach
+ * @return wskaźnik na blok
+ */
+void* PolyRealloc(void* ptr, size_t size);
+
+/**
+ * Zwalnia blok przydzielony przez PolyMalloc lub PolyRealloc.
+ * @param[in] ptr : blok lub NULL
+ */
+void PolyFree(void* ptr);
+
+/**
+ * Dodaje właściciela bloku. Każdy blok ma licznik właścicieli, równy jeden
+ * po przydzieleniu.
+ * @param[in] ptr : blok
+ */
+void PolyBlockRetain(void* ptr);
+
+/**
+ * Usuwa właściciela bloku. Bloku nie zwalnia, zwolnienie należy do
+ * ostatniego właściciela.
+ * @param[in] ptr : blok
+ * @return Czy był to ostatni właściciel bloku?
+ */
+bool PolyBlockRelease(void* ptr);
+
+/**
+ * Sprawdza, czy blok ma więcej niż jednego właściciela.
+ * @param[in] ptr : blok
+ * @return Czy blok jest współdzielony?
+ */
+bool PolyBlockIsShared(const void* ptr);
+
+/**
+ * Oznacza blok jako należący do tablicy unikalnych wielomianów.
+ * @param[in] ptr : blok
+ */
+void PolyBlockSetInterned(void* ptr);
+
+/**
+ * Sprawdza, czy blok należy do tablicy unikalnych wielomianów.
+ * @param[in] ptr : blok
+ * @return Czy blok jest w tablicy unikalnych wielomianów?
+ */
+bool PolyBlockIsInterned(const void* ptr);
+
+/**
+ * Zwraca dane zapamiętane dla zawartości bloku.
+ * @param[in] ptr : blok
+ * @return blok z danymi przydzielony przez PolyMalloc lub NULL
+ */
+void* PolyBlockMeta(const void* ptr);
+
+/**
+ * Zapamiętuje dane dla zawartości bloku, zwalniając poprzednie. Dane są
+ * zwalniane razem z blokiem i przy każdej zmianie jego wielkości.
+ * @param[in] ptr : blok
+ * @param[in] meta : blok z danymi przydzielony przez PolyMalloc lub NULL
+ */
+void PolyBlockSetMeta(void* ptr, void* meta);
+
+/**
+ * Oddaje systemowi wszystkie wolne bloki przechowywane przez bieżący wątek.
+ */
+void PolyAllocRelease(void);
+
+#endif /* POLY_ALLOC_H */
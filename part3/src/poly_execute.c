@@ -3,19 +3,16 @@
  *  @author Patrycja Stępień
 */
 
-/**
- * Makro potrzebne do prawidłowego wykonywania funkcji getline
- */
-#define _GNU_SOURCE
-
-#include <ctype.h>
-#include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
-#include <stdlib.h>
-#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#if defined(__SSE2__) && !defined(POLY_NO_SIMD)
+#include <emmintrin.h>
+#endif
 #include "poly_execute.h"
-#include "tools.h"
+#include "output.h"
 #include "poly.h"
 #include "stack.h"
 
@@ -25,423 +22,280 @@
 #define DECIMAL_BASE 10
 
 /**
- * Brak wczytanych danych.
+ * Stan parsera wielomianu. Parser czyta znaki bezpośrednio z bufora
+ * wiersza, bez wycinania z niego napisów, i w jednym przejściu sprawdza
+ * poprawność wielomianu oraz go tworzy.
  */
-#define NONE -1
-
-/**
- * Sprawdza, czy napis reprezentuje poprawny współczynnik.
- * @param[in] polyS : sprawdzany napis
- * @param[in] lineSize : długość napisu
- * @return czy jest poprawnym współczynnikiem
- */
-static bool IsStringCoeff(char const* polyS, size_t lineSize) {
-    // lineSize - 1 bo ostatni przechowywany znak to znak nowej linii
-    for (size_t i = 0; i < lineSize - 1; i++) {
-        if (polyS[i] == '-') {
-            if (i != 0) {
-                return false;
-            } else {
-                continue;
-            }
-        }
-        if (!isdigit(polyS[i])) {
-            return false;
-        }
-    }
-    return true;
-}
+typedef struct PolyParser {
+    const char* pos; ///< bieżący znak
+    const char* end; ///< pierwszy znak za parsowanym wierszem
+} PolyParser;
 
 /**
- * Sprawdza, czy znak jest dozwolonym w wielomianach.
+ * Sprawdza, czy znak jest cyfrą dziesiętną.
  * @param[in] c : sprawdzany znak
- * @return czy jest dozwolonym znakiem
+ * @return czy znak jest cyfrą
  */
-static bool IsCorrectSign(char c) {
-    return c == '+' || c == '-' || c == '(' || c == ')' || isdigit(c) || c == ',';
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
 }
 
 /**
- * Sprawdza, z ilu osobnych jednomianów składa się wczytywany wielomian.
- * @param[in] polyS : wczytywany wielomian
- * @param[in] lineSize : długość napisu reprezentującego wczytywany wielomian
- * @return z ilu jednomianów składa się wielomian
+ * Wczytuje zadany znak, jeśli jest on bieżącym znakiem parsera.
+ * @param[in, out] parser : parser
+ * @param[in] c : oczekiwany znak
+ * @return czy bieżącym znakiem był @p c
  */
-static int HowManyMonos(char const* polyS, size_t lineSize) {
-    int howMany = 1;
-    int numOfLeftBraces = 0;
-    int numOfRightBraces = 0;
-
-    for (size_t i = 0; i < lineSize - 1; i++) {
-        if (polyS[i] == '(')
-            numOfLeftBraces++;
-        if (polyS[i] == ')')
-            numOfRightBraces++;
-        if (numOfLeftBraces == numOfRightBraces && polyS[i] == '+' && numOfRightBraces > 0)
-            howMany++;
+static bool Accept(PolyParser* parser, char c) {
+    if (parser->pos < parser->end && *(parser->pos) == c) {
+        (parser->pos)++;
+        return true;
     }
-    return howMany;
+    return false;
 }
 
 /**
- * Sprawdza, czy napis reprezentuje poprawny wielomian.
- * @param[in] polyS : wczytywany wielomian
- * @param[in] lineSize : długość napisu reprezentującego wczytywany wielomian
- * @return czy napis to poprawny wielomian
+ * Liczba bajtów słowa, w którym cyfry dekodowane są jednocześnie.
  */
-static bool IsCorrectPoly(char const* polyS, size_t lineSize) {
-    if (IsStringCoeff(polyS, lineSize)) {
-        return true;
-    }
-    if (polyS == NULL) {
-        return false;
-    }
-    if (polyS[0] != '(') {
-        return false;
-    }
-    if (polyS[lineSize - 1] != '\n' && polyS[lineSize - 1] != ')') {
-        return false;
-    }
-    int numOfLeftBraces = 1;
-    int numOfRightBraces = 0;
-    int numOfComas = 0;
-    for (size_t i = 1; i < lineSize - 1; i++) {
-        if (!IsCorrectSign(polyS[i])) {
-            return false;
-        }
-        if (polyS[i] == ',') {
-            if (polyS[i - 1] != ')' && !isdigit(polyS[i - 1])) {
-                return false;
-            }
-            if (!isdigit(polyS[i + 1])) {
-                return false;
-            }
-            numOfComas++;
-        }
-        if (polyS[i] == '(') {
-            if (polyS[i - 1] != '+' && polyS[i - 1] != '(') {
-                return false;
-            }
-            if (polyS[i + 1] != '(' && polyS[i + 1] != '-' && !isdigit(polyS[i + 1])) {
-                return false;
-            }
-            numOfLeftBraces++;
-        }
-        if (polyS[i] == ')') {
-            if (!isdigit(polyS[i - 1])) {
-                return false;
-            }
-            if (polyS[i + 1] != '+' && polyS[i + 1] != ',' && polyS[i + 1] != '\n') {
-                return false;
-            }
-            numOfRightBraces++;
-        }
-        if (polyS[i] == '-') {
-            if (polyS[i - 1] != '(') {
-                return false;
-            }
-            if (!isdigit(polyS[i + 1])) {
-                return false;
-            }
-        }
-        if (polyS[i] == '+') {
-            if (polyS[i - 1] != ')') {
-                return false;
-            }
-            if (polyS[i + 1] != '(') {
-                return false;
-            }
-        }
-        if (numOfRightBraces > numOfLeftBraces) {
-            return false;
-        }
-    }
-    if (numOfLeftBraces != numOfRightBraces) {
-        return false;
-    }
-    if (numOfRightBraces != numOfComas) {
-        return false;
-    }
+#define SWAR_DIGITS 8
 
-    return true;
-}
+/**
+ * Najdłuższy ciąg cyfr dekodowany dwoma słowami. Dłuższe liczby czytane są
+ * cyfra po cyfrze ze sprawdzaniem przekroczenia zakresu po każdej cyfrze.
+ */
+#define SWAR_MAX_DIGITS (2 * SWAR_DIGITS)
 
 /**
- * Parsuje współczynnik wielomianu i sprawdza czy jest on w dozwolonym zakresie.
- * @param[in] polyS : wczytywany wielomian
- * @param[in, out] okPoly : czy wczytywany wielomian jest poprawny
- * @return sparsowany wspołczynnik wielomianu
+ * Bajty słowa powtarzające zadaną wartość.
  */
-static poly_coeff_t ParseCoeff(char const* polyS, bool* okPoly) {
-    char* pEnd;
-    poly_coeff_t c = strtol(polyS, &pEnd, DECIMAL_BASE);
-    if (errno == ERANGE || (strcmp(pEnd, "\n") != 0 && strcmp(pEnd, "\0") != 0)) {
-        *okPoly = false;
-    }
-    return c;
-}
+#define SWAR_BYTES(b) (0x0101010101010101ULL * (b))
 
 /**
- * Zwraca indeks końca wczytywanego jednomianu.
- * @param[in] indStart : początek sprawdzania
- * @param[in] lineSize : długość sprawdzanej linii
- * @param[in] polyS : sprawdzana linia
- * @return indeks końca jednomianu
+ * Waga pierwszego słowa cyfr: 10 do potęgi @ref SWAR_DIGITS.
  */
-static size_t IterateTillMonoEnd(size_t indStart, size_t lineSize, char const* polyS) {
-    size_t i = indStart;
-    int numOfLeftBraces = 0;
-    int numOfRightBraces = 0;
+#define SWAR_DIGITS_BASE 100000000ULL
 
-    while (i < lineSize) {
-        if (polyS[i] == '(') {
-            numOfLeftBraces++;
-        }
-        if (polyS[i] == ')') {
-            numOfRightBraces++;
-        }
-        if (numOfLeftBraces == numOfRightBraces &&
-            polyS[i] == '+' &&
-            numOfRightBraces > 0) {
-            return i;
+/**
+ * Liczy długość ciągu cyfr zaczynającego się od zadanego znaku. Z SSE2
+ * sprawdza 16 znaków jednym porównaniem, resztę znak po znaku.
+ * @param[in] pos : pierwszy znak
+ * @param[in] end : pierwszy znak za wierszem
+ * @return długość ciągu cyfr
+ */
+static size_t DigitRunLength(const char* pos, const char* end) {
+    const char* begin = pos;
+#if defined(__SSE2__) && !defined(POLY_NO_SIMD)
+    // Cyfrą jest bajt b, dla którego b - '0' jest bez znaku mniejsze od 10.
+    // SSE2 porównuje tylko liczby ze znakiem, więc przesuwamy zakres o 0x80.
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i bias = _mm_set1_epi8((char) 0x80);
+    const __m128i bound = _mm_set1_epi8((char) (0x80 + DECIMAL_BASE));
+    while (end - pos >= (ptrdiff_t) sizeof(__m128i)) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) pos);
+        __m128i shifted = _mm_xor_si128(_mm_sub_epi8(chunk, zero), bias);
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmplt_epi8(shifted, bound));
+        if (mask != 0xFFFF) {
+            return (size_t) (pos - begin) + (size_t) __builtin_ctz(~mask);
         }
-        i++;
+        pos += sizeof(__m128i);
+    }
+#endif
+    while (pos < end && IsDigit(*pos)) {
+        pos++;
     }
-    // koniec ostatniego jednomianu to znak nowej linii
-    i--;
-    return i;
+    return (size_t) (pos - begin);
 }
 
 /**
- * Wycina z napisu reprezentującego wielomian napis reprezentujący jednomian.
- * @param[in, out] polyS : napis reprezentujący wielomian
- * @param[in] lineSize : długość linii
- * @param[in] indStart : początek wycinania
- * @return napis reprezentujący jednomian
+ * Dekoduje jednocześnie cyfry zapisane w bajtach słowa. Pierwsza, najbardziej
+ * znacząca cyfra jest w najmłodszym bajcie. Kolejne kroki łączą sąsiednie
+ * pary cyfr, potem czwórki i ósemki.
+ * @param[in] digits : słowo z wartościami cyfr 0-9 w każdym bajcie
+ * @return wartość liczby
  */
-static char* CutMono(char* polyS, size_t lineSize, size_t* indStart) {
-    size_t wordBegin = *indStart;
-    char* word = &(polyS[wordBegin]);
-
-    size_t firstIndexAfterMono = IterateTillMonoEnd(*indStart, lineSize, polyS);
-    polyS[firstIndexAfterMono] = '\0';
-
-    size_t sizeOfExtractedMono = firstIndexAfterMono - wordBegin + 1;
-    char* extractedMono = malloc(sizeOfExtractedMono * sizeof(char));
-    if (extractedMono == NULL) {
-        exit(1);
-    }
-    sscanf(word, "%s", extractedMono);
-
-    *indStart = firstIndexAfterMono;
-    return extractedMono;
+static uint64_t SwarDecode(uint64_t digits) {
+    digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+    digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+    digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFULL;
+    return digits;
 }
 
 /**
- * Zwraca indeks przecinka poprzedzającego wykładnik jednomianu,
- * używane przy parsowaniu wielomianu.
- * @param[in] monoToParse : napis reprezentujący jednomian
- * @param[in] monoSize : długość napisu reprezentującego jednomian
- * @return indeks przecinka
+ * Dekoduje od 1 do @ref SWAR_DIGITS cyfr, czytając całe słowo.
+ * @param[in] pos : pierwsza cyfra, za nią musi być co najmniej
+ *                  @ref SWAR_DIGITS bajtów wiersza licząc od niej
+ * @param[in] length : liczba cyfr
+ * @return wartość liczby
  */
-static size_t FindComaBeforeExp(char const* monoToParse, size_t monoSize) {
-    size_t i = monoSize - 1;
-    while (true) {
-        if (monoToParse[i] == ',') {
-            return i;
-        }
-        i--;
-    }
-    return i;
+static uint64_t SwarLoad(const char* pos, size_t length) {
+    uint64_t digits;
+    memcpy(&digits, pos, sizeof(digits));
+    // Bajty za cyframi wypadają przy przesunięciu, a na ich miejsce
+    // wchodzą zera wiodące.
+    digits = (digits - SWAR_BYTES('0')) << (8 * (SWAR_DIGITS - length));
+    return SwarDecode(digits);
 }
 
 /**
- * Wycina z napisu reprezentującego jednomian napis reprezentujący wykładnik.
- * @param[in] monoToParse : napis reprezentujący jednomian
- * @param[in] monoSize : długość linii
- * @param[in] expBegin : początek wycinania
- * @return napis reprezentujący wykładnik
+ * Wczytuje niepusty ciąg cyfr dziesiętnych i sprawdza, czy jego wartość
+ * nie przekracza zadanego ograniczenia. Krótkie liczby są dekodowane
+ * słowami po @ref SWAR_DIGITS cyfr, gdy słowo mieści się w wierszu.
+ * @param[in, out] parser : parser
+ * @param[in] limit : największa dozwolona wartość
+ * @param[out] value : wczytana wartość
+ * @return czy wczytano poprawną liczbę
  */
-static char* CutExp(char* monoToParse, size_t monoSize, size_t expBegin) {
-    char* word = &monoToParse[expBegin];
-
-    // prawy nawias za wykladnikiem jednomianu
-    size_t firstIndexAfterExp = monoSize - 1;
-    monoToParse[firstIndexAfterExp] = '\0';
-
-    size_t sizeOfExtractedExp = firstIndexAfterExp - expBegin + 1;
-    char* extractedExp = malloc(sizeOfExtractedExp * sizeof(char));
-    if (extractedExp == NULL) {
-        exit(1);
+static bool ParseDigits(PolyParser* parser, uint64_t limit, uint64_t* value) {
+    const char* pos = parser->pos;
+    size_t length = DigitRunLength(pos, parser->end);
+    if (length == 0) {
+        return false;
     }
-    sscanf(word, "%s", extractedExp);
 
-    monoToParse[firstIndexAfterExp] = ')';
-    return extractedExp;
+    uint64_t result = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (length <= SWAR_MAX_DIGITS && parser->end - pos >= SWAR_DIGITS) {
+        if (length <= SWAR_DIGITS) {
+            result = SwarLoad(pos, length);
+        } else {
+            result = SwarLoad(pos, length - SWAR_DIGITS) * SWAR_DIGITS_BASE +
+                     SwarLoad(pos + length - SWAR_DIGITS, SWAR_DIGITS);
+        }
+        if (result > limit) {
+            return false;
+        }
+        parser->pos += length;
+        *value = result;
+        return true;
+    }
+#endif
+    for (size_t i = 0; i < length; i++) {
+        uint64_t digit = (uint64_t) (pos[i] - '0');
+        if (result > (limit - digit) / DECIMAL_BASE) {
+            return false;
+        }
+        result = result * DECIMAL_BASE + digit;
+    }
+    parser->pos += length;
+    *value = result;
+    return true;
 }
 
 /**
- * Parsuje wykładnik jednomianu i sprawdza czy jest on w dozwolonym zakresie.
- * @param[in] expS : napis reprezentujący wykładnik
- * @param[in, out] okPoly : czy wczytywany wielomian jest poprawny
- * @return sparsowany wykładnik jednomianu
+ * Parsuje współczynnik wielomianu i sprawdza czy jest on w dozwolonym zakresie.
+ * @param[in, out] parser : parser
+ * @param[out] c : sparsowany współczynnik
+ * @return czy wczytano poprawny współczynnik
  */
-static poly_exp_t ParseExp(char const* expS, bool* okPoly) {
-    poly_exp_t e;
-    int itemsRead = sscanf(expS, "%d", &e);
-    if (itemsRead == NONE) {
-        *okPoly = false;
+static bool ParseCoeff(PolyParser* parser, poly_coeff_t* c) {
+    bool negative = Accept(parser, '-');
+    uint64_t limit = negative ? (uint64_t) LONG_MAX + 1 : (uint64_t) LONG_MAX;
+    uint64_t value;
+    if (!ParseDigits(parser, limit, &value)) {
+        return false;
     }
-    return e;
+    *c = (poly_coeff_t) (negative ? 0 - value : value);
+    return true;
 }
 
 /**
- * Znajduje początek wielomianu będącego współczynnikiem jednomianu.
- * @param[in] monoToParse : napis reprezentujący parsowany jednomian
- * @param[in] monoSize : długość napisu reprezentującego parsowany jednomian
- * @return indeks początku wielomianu
+ * Parsuje wykładnik jednomianu i sprawdza czy jest on w dozwolonym zakresie.
+ * @param[in, out] parser : parser
+ * @param[out] exp : sparsowany wykładnik
+ * @return czy wczytano poprawny wykładnik
  */
-static size_t FindPolyAsCoeffBegin(char const* monoToParse, size_t monoSize) {
-    size_t i = monoSize;
-    int numOfLeftBraces = 0;
-    int numOfRightBraces = 0;
-
-    while (true) {
-        if (monoToParse[i] == ')') {
-            numOfRightBraces++;
-        }
-        if (monoToParse[i] == '(') {
-            numOfLeftBraces++;
-        }
-        if (numOfLeftBraces == numOfRightBraces &&
-            monoToParse[i] == '(' &&
-            numOfRightBraces > 0) {
-            return i;
-        }
-        i--;
+static bool ParseExp(PolyParser* parser, poly_exp_t* exp) {
+    uint64_t value;
+    if (!ParseDigits(parser, INT_MAX, &value)) {
+        return false;
     }
-
-    return i;
+    *exp = (poly_exp_t) value;
+    return true;
 }
 
 /**
- * Wycina z napisu jednomiany, parsuje je i tworzy z nich wielomian.
- * @param[in] polyS : napis reprezentujący parsowany wielomian
- * @param[in] lineSize : długość napisu reprezentującego parsowany wielomian
- * @param[in, out] okPoly : czy wczytywany wielomian jest poprawny
- * @return sparsowany wielomian
+ * Parsuje sumę jednomianów.
+ * @param[in, out] parser : parser, bieżącym znakiem jest lewy nawias
+ *                          pierwszego jednomianu
+ * @param[out] result : sparsowany wielomian
+ * @return czy wczytano poprawny wielomian
  */
-static Poly Parse(char* polyS, size_t lineSize, bool* okPoly);
+static bool ParseMonos(PolyParser* parser, Poly* result);
 
 /**
- * Parsuje jednomian.
- * @param[in] monoToParse : napis reprezentujący parsowany jednomian
- * @param[in] monoSize : długość napisu reprezentującego parsowany jednomian
- * @param[in, out] okPoly : czy wczytywany wielomian jest poprawny
- * @return sparsowany jednomian
+ * Parsuje jednomian bez otwierającego go lewego nawiasu.
+ * @param[in, out] parser : parser
+ * @param[out] m : sparsowany jednomian
+ * @return czy wczytano poprawny jednomian
  */
-static Mono ParseMono(char* monoToParse, size_t monoSize, bool* okPoly) {
-    Mono parsedMono;
-
-    size_t expBegin = FindComaBeforeExp(monoToParse, monoSize) + 1;
-    char* expS = CutExp(monoToParse, monoSize, expBegin);
-
-    parsedMono.exp = ParseExp(expS, okPoly);
-    free(expS);
-    size_t polyAsCoeffBegin = FindPolyAsCoeffBegin(monoToParse, monoSize) + 1;
-    size_t polyAsCoeffEnd = expBegin - 1;
-
-    char* coeffS = Cut(monoToParse, polyAsCoeffBegin, polyAsCoeffEnd);
-    if (monoToParse[polyAsCoeffEnd - 1] == ')') {
-        size_t lineSize = polyAsCoeffEnd - polyAsCoeffBegin + 1;
-        parsedMono.p = Parse(coeffS, lineSize, okPoly);
+static bool ParseMono(PolyParser* parser, Mono* m) {
+    Poly p;
+    if (parser->pos < parser->end && *(parser->pos) == '(') {
+        if (!ParseMonos(parser, &p)) {
+            return false;
+        }
     } else {
-        char* pEnd;
-        poly_coeff_t c = strtol(coeffS, &pEnd, 0);
-        if (errno == ERANGE) {
-            *okPoly = false;
+        poly_coeff_t c;
+        if (!ParseCoeff(parser, &c)) {
+            return false;
         }
-        parsedMono.p = PolyFromCoeff(c);
+        p = PolyFromCoeff(c);
     }
-    free(coeffS);
-
-    return parsedMono;
-}
 
-static Poly Parse(char* polyS, size_t lineSize, bool* okPoly) {
-    int howMany = HowManyMonos(polyS, lineSize);
-    Mono* monos = malloc(howMany * sizeof(Mono));
-    if(monos == NULL) {
-        exit(1);
+    poly_exp_t exp;
+    if (!Accept(parser, ',') || !ParseExp(parser, &exp) || !Accept(parser, ')')) {
+        PolyDestroy(&p);
+        return false;
     }
+    *m = MonoFromPoly(&p, exp);
+    return true;
+}
 
-    // indStart będzie wskazywał na początek następnego wycinanego napisu.
-    size_t indStart = 0;
-    for (int i = 0; i < howMany; i++) {
-        // Po wywołaniu CutMono indStart wskazuje na plus pomiedzy
-        // jednomianami lub na pierwszy indeks za wielomianem.
-        size_t monoBegin = indStart;
-        char* monoToParse = CutMono(polyS, lineSize, &indStart);
-
-        // Ustawiamy go tak, aby przed kolejnym wywołaniem wskazywał na
-        // pierwszy lewy nawias następnego jednomianu.
-        if (indStart < lineSize) {
-            indStart++;
+static bool ParseMonos(PolyParser* parser, Poly* result) {
+    PolyBuilder builder = PolyBuilderCreate(0);
+    do {
+        Mono m;
+        if (!Accept(parser, '(') || !ParseMono(parser, &m)) {
+            PolyBuilderDestroy(&builder);
+            return false;
         }
+        PolyBuilderAppend(&builder, &m);
+    } while (Accept(parser, '+'));
 
-        // Rozmiar bez znaku '\0'.
-        size_t monoSize = indStart - monoBegin - 1;
-        Mono mono = ParseMono(monoToParse, monoSize, okPoly);
-        monos[i] = mono;
-        free(monoToParse);
-    }
-    Poly res = PolyAddMonos(howMany, monos);
-    free(monos);
-
-    return res;
+    *result = PolyBuilderFinish(&builder);
+    return true;
 }
 
-/**
- * Parsuje i wrzuca na stos wczytany ze standardowego wejścia napis reprezentujący wielomian
- * @param[in, out] stack : stos
- * @param[in] polyS : napis reprezentujący parsowany wielomian
- * @param[in] lineSize : długość napisu reprezentującego parsowany wielomian
- * @param[in] lineNumber : numer wczytanego wiersza
- */
-static void ParsePoly(Stack* stack, char* polyS, size_t lineSize, int lineNumber) {
-    if (!IsCorrectPoly(polyS, lineSize)) {
-        fprintf(stderr, "ERROR %u WRONG POLY\n", lineNumber);
-        return;
+bool PolyParse(const char* line, size_t lineSize, Poly* result) {
+    PolyParser parser = {.pos = line, .end = line + lineSize};
+    if (lineSize > 0 && line[lineSize - 1] == '\n') {
+        (parser.end)--;
     }
 
-    Poly newPoly;
-    bool okPoly = true;
-    if (IsStringCoeff(polyS, lineSize)) {
-        poly_coeff_t c = ParseCoeff(polyS, &okPoly);
-        if (okPoly) {
-            newPoly = PolyFromCoeff(c);
+    if (parser.pos < parser.end && *(parser.pos) == '(') {
+        if (!ParseMonos(&parser, result)) {
+            return false;
         }
     } else {
-        newPoly = Parse(polyS, lineSize, &okPoly);
+        poly_coeff_t c;
+        if (!ParseCoeff(&parser, &c)) {
+            return false;
+        }
+        *result = PolyFromCoeff(c);
     }
 
-    if (okPoly) {
-        Push(stack, newPoly);
-    } else {
-        fprintf(stderr, "ERROR %u WRONG POLY\n", lineNumber);
+    if (parser.pos != parser.end) {
+        PolyDestroy(result);
+        return false;
     }
+    return true;
 }
 
-void PolyScan(Stack* stack, int lineNumber) {
-    char* polyS = NULL;
-    size_t length = 0;
-    ssize_t lineSize = 0;
-
-    lineSize = getline(&polyS, &length, stdin);
-    if (polyS == NULL) {
-        exit(1);
+void PolyScan(Stack* stack, char const* line, size_t lineSize, int lineNumber) {
+    Poly newPoly;
+    if (PolyParse(line, lineSize, &newPoly)) {
+        Push(stack, newPoly);
+    } else {
+        OutputError(lineNumber, "WRONG POLY");
     }
-
-    ParsePoly(stack, polyS, lineSize, lineNumber);
-    free(polyS);
 }
@@ -5,13 +5,27 @@
 #ifndef POLY_EXECUTE_H
 #define POLY_EXECUTE_H
 
+#include <stdbool.h>
+#include "poly.h"
 #include "stack.h"
 
 /**
- * Wczytuje z wielomian ze standardowego wejścia.
- * @param[in] stack : stos
+ * Parsuje wiersz reprezentujący wielomian: współczynnik albo sumę
+ * jednomianów, po której może wystąpić już tylko znak nowej linii.
+ * @param[in] line : wiersz, może nie kończyć się znakiem nowej linii
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[out] result : sparsowany wielomian
+ * @return czy wiersz jest poprawnym wielomianem
+ */
+bool PolyParse(char const* line, size_t lineSize, Poly* result);
+
+/**
+ * Parsuje wiersz z wielomianem i wrzuca wielomian na stos.
+ * @param[in, out] stack : stos
+ * @param[in] line : wiersz z wielomianem, może nie kończyć się znakiem nowej linii
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
  * @param[in] lineNumber : numer wczytanego wiersza
  */
-void PolyScan(Stack* stack, int lineNumber);
+void PolyScan(Stack* stack, char const* line, size_t lineSize, int lineNumber);
 
 #endif /* POLY_EXECUTE_H */
\ No newline at end of file
@@ -0,0 +1,219 @@
+/** @file
+ *  Implementacja kompilacji wielomianu do taśmy instrukcji i obliczania
+ *  wartości taśmy w punkcie.
+ *  @author Patrycja Stępień
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "poly_alloc.h"
+#include "poly_tape.h"
+
+/**
+ * Rodzaje instrukcji taśmy.
+ */
+enum PolyTapeOpKind {
+    TAPE_PUSH_ZERO, ///< odłóż zero na stos wartości
+    TAPE_ADD_COEFF, ///< dodaj współczynnik razy potęgę do wierzchołka
+    TAPE_ADD_VALUE ///< zdejmij wartość i dodaj ją razy potęgę do wierzchołka
+};
+
+/**
+ * Indeks potęgi o wykładniku zero, równej zawsze 1.
+ */
+#define TAPE_POWER_ONE 0
+
+/**
+ * Tablica mieszająca przypisująca potędze zmiennej jej indeks w tablicy
+ * potęg taśmy. Zero oznacza puste miejsce, bo potęga o indeksie
+ * TAPE_POWER_ONE nie jest w niej przechowywana.
+ */
+typedef struct TapePowerIndex {
+    uint32_t* slots; ///< indeksy potęg
+    size_t mask; ///< liczba miejsc pomniejszona o jeden
+} TapePowerIndex;
+
+/**
+ * Liczy instrukcje taśmy, jednomiany o dodatnich wykładnikach i zmienne,
+ * od których zależy wielomian.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] var : indeks zmiennej wielomianu
+ * @param[in, out] opsCount : liczba instrukcji
+ * @param[in, out] powersCount : liczba jednomianów o dodatnich wykładnikach
+ * @param[in, out] vars : liczba zmiennych
+ */
+static void CountOps(const Poly *p, size_t var, size_t* opsCount,
+                     size_t* powersCount, size_t* vars) {
+    if (var + 1 > *vars) {
+        *vars = var + 1;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        const Mono* m = &(p->arr[i]);
+        if (m->exp > 0) {
+            (*powersCount)++;
+        }
+        if (PolyIsCoeff(&(m->p))) {
+            (*opsCount)++;
+        } else {
+            *opsCount += 2;
+            CountOps(&(m->p), var + 1, opsCount, powersCount, vars);
+        }
+    }
+}
+
+/**
+ * Zwraca indeks potęgi w tablicy potęg taśmy, dopisując ją, jeśli
+ * wcześniej nie wystąpiła.
+ * @param[in, out] tape : taśma
+ * @param[in, out] index : tablica mieszająca potęg taśmy
+ * @param[in] var : indeks zmiennej
+ * @param[in] exp : wykładnik
+ * @return indeks potęgi
+ */
+static uint32_t FindPower(PolyTape* tape, TapePowerIndex* index,
+                          size_t var, poly_exp_t exp) {
+    if (exp == 0) {
+        return TAPE_POWER_ONE;
+    }
+    uint64_t hash = ((uint64_t) var << 32 | (uint32_t) exp) * 0x9E3779B97F4A7C15ULL;
+    size_t slot = (size_t) (hash >> 32) & index->mask;
+    while (index->slots[slot] != 0) {
+        const PolyTapePower* key = &(tape->powerKeys[index->slots[slot]]);
+        if (key->var == var && key->exp == exp) {
+            return index->slots[slot];
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    uint32_t power = (uint32_t) (tape->powersCount)++;
+    tape->powerKeys[power] = (PolyTapePower) {.var = var, .exp = exp};
+    index->slots[slot] = power;
+    return power;
+}
+
+/**
+ * Zapisuje instrukcje obliczające wartość wielomianu i dodające ją
+ * do wierzchołka stosu wartości.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] var : indeks zmiennej wielomianu
+ * @param[in, out] tape : taśma
+ * @param[in, out] index : tablica mieszająca potęg taśmy
+ */
+static void EmitOps(const Poly *p, size_t var, PolyTape* tape, TapePowerIndex* index) {
+    for (size_t i = 0; i < p->size; i++) {
+        const Mono* m = &(p->arr[i]);
+        uint32_t power = FindPower(tape, index, var, m->exp);
+        if (PolyIsCoeff(&(m->p))) {
+            tape->ops[(tape->opsCount)++] = (PolyTapeOp) {
+                .kind = TAPE_ADD_COEFF, .power = power, .coeff = m->p.coeff};
+        } else {
+            tape->ops[(tape->opsCount)++] = (PolyTapeOp) {.kind = TAPE_PUSH_ZERO};
+            EmitOps(&(m->p), var + 1, tape, index);
+            tape->ops[(tape->opsCount)++] = (PolyTapeOp) {
+                .kind = TAPE_ADD_VALUE, .power = power};
+        }
+    }
+}
+
+PolyTape PolyCompileEval(const Poly *p) {
+    PolyTape tape = {.vars = 0, .opsCount = 0, .powersCount = 1};
+    size_t opsCount = 2;
+    size_t maxPowers = 0;
+    if (!PolyIsCoeff(p)) {
+        opsCount = 1;
+        CountOps(p, 0, &opsCount, &maxPowers, &(tape.vars));
+    }
+
+    tape.ops = PolyMalloc(opsCount * sizeof(PolyTapeOp));
+    tape.powerKeys = PolyMalloc((maxPowers + 1) * sizeof(PolyTapePower));
+    tape.powerKeys[TAPE_POWER_ONE] = (PolyTapePower) {.var = 0, .exp = 0};
+    tape.values = PolyMalloc((tape.vars + 1) * sizeof(uint64_t));
+
+    tape.ops[(tape.opsCount)++] = (PolyTapeOp) {.kind = TAPE_PUSH_ZERO};
+    if (PolyIsCoeff(p)) {
+        tape.ops[(tape.opsCount)++] = (PolyTapeOp) {
+            .kind = TAPE_ADD_COEFF, .power = TAPE_POWER_ONE, .coeff = p->coeff};
+    } else {
+        // Tablica mieszająca jest zapełniona co najwyżej w połowie.
+        size_t capacity = 1;
+        while (capacity < 2 * maxPowers) {
+            capacity *= 2;
+        }
+        TapePowerIndex index = {.mask = capacity - 1};
+        index.slots = PolyMalloc(capacity * sizeof(uint32_t));
+        memset(index.slots, 0, capacity * sizeof(uint32_t));
+        EmitOps(p, 0, &tape, &index);
+        PolyFree(index.slots);
+    }
+
+    tape.powers = PolyMalloc(tape.powersCount * sizeof(uint64_t));
+    tape.powers[TAPE_POWER_ONE] = 1;
+    return tape;
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @f$2^{64}@f$ przez podnoszenie do kwadratu.
+ * @param[in] base : podstawa
+ * @param[in] exp : wykładnik
+ * @return @f$base^{exp}@f$
+ */
+static uint64_t PowerU64(uint64_t base, poly_exp_t exp) {
+    uint64_t result = 1;
+    while (exp > 0) {
+        if (exp & 1) {
+            result *= base;
+        }
+        base *= base;
+        exp >>= 1;
+    }
+    return result;
+}
+
+poly_coeff_t PolyTapeEval(PolyTape *tape, size_t k, const Poly q[]) {
+    // Potęgi jednomianów sąsiednich w wielomianie trafiają do tablicy
+    // kolejno, więc wyższą potęgę tej samej zmiennej liczymy z poprzedniej,
+    // podnosząc zmienną tylko do różnicy wykładników.
+    for (size_t i = 1; i < tape->powersCount; i++) {
+        const PolyTapePower* key = &(tape->powerKeys[i]);
+        const PolyTapePower* prev = &(tape->powerKeys[i - 1]);
+        uint64_t x = key->var < k ? (uint64_t) q[key->var].coeff : 0;
+        if (i > 1 && prev->var == key->var && prev->exp < key->exp) {
+            tape->powers[i] = tape->powers[i - 1] * PowerU64(x, key->exp - prev->exp);
+        } else {
+            tape->powers[i] = PowerU64(x, key->exp);
+        }
+    }
+
+    uint64_t* values = tape->values;
+    const uint64_t* powers = tape->powers;
+    size_t top = 0;
+    for (size_t i = 0; i < tape->opsCount; i++) {
+        const PolyTapeOp* op = &(tape->ops[i]);
+        switch (op->kind) {
+            case TAPE_PUSH_ZERO:
+                values[top++] = 0;
+                break;
+            case TAPE_ADD_COEFF:
+                values[top - 1] += (uint64_t) op->coeff * powers[op->power];
+                break;
+            case TAPE_ADD_VALUE:
+                top--;
+                values[top - 1] += values[top] * powers[op->power];
+                break;
+        }
+    }
+    return (poly_coeff_t) values[0];
+}
+
+void PolyTapeDestroy(PolyTape *tape) {
+    PolyFree(tape->ops);
+    PolyFree(tape->powerKeys);
+    PolyFree(tape->powers);
+    PolyFree(tape->values);
+    tape->ops = NULL;
+    tape->powerKeys = NULL;
+    tape->powers = NULL;
+    tape->values = NULL;
+    tape->opsCount = 0;
+    tape->powersCount = 0;
+}
@@ -0,0 +1,76 @@
+/** @file
+ *  Skompilowana postać wielomianu do wielokrotnego obliczania jego
+ *  wartości liczbowej w punktach.
+ *  @author Patrycja Stępień
+*/
+
+#ifndef POLY_TAPE_H
+#define POLY_TAPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Pojedyncza instrukcja taśmy. Taśma wykonywana jest na stosie wartości:
+ * instrukcja TAPE_PUSH_ZERO odkłada zero, TAPE_ADD_COEFF dodaje do wartości
+ * na wierzchołku współczynnik pomnożony przez potęgę z tablicy potęg,
+ * a TAPE_ADD_VALUE zdejmuje wartość z wierzchołka i dodaje ją, pomnożoną
+ * przez potęgę, do nowego wierzchołka.
+ */
+typedef struct PolyTapeOp {
+    uint32_t kind; ///< rodzaj instrukcji
+    uint32_t power; ///< indeks potęgi w tablicy potęg
+    poly_coeff_t coeff; ///< współczynnik dla TAPE_ADD_COEFF
+} PolyTapeOp;
+
+/**
+ * Potęga zmiennej używana przez taśmę.
+ */
+typedef struct PolyTapePower {
+    size_t var; ///< indeks zmiennej
+    poly_exp_t exp; ///< wykładnik
+} PolyTapePower;
+
+/**
+ * Skompilowany wielomian: ciąg instrukcji mnożenia i dodawania oraz
+ * tablica potęg zmiennych wspólna dla wszystkich jednomianów. Obliczenie
+ * wartości nie alokuje pamięci, bo tablice robocze są częścią taśmy.
+ */
+typedef struct PolyTape {
+    PolyTapeOp* ops; ///< instrukcje
+    size_t opsCount; ///< liczba instrukcji
+    PolyTapePower* powerKeys; ///< potęgi w kolejności pierwszego użycia
+    uint64_t* powers; ///< wartości potęg, pierwsza z nich to zawsze 1
+    size_t powersCount; ///< liczba potęg
+    uint64_t* values; ///< stos wartości
+    size_t vars; ///< liczba zmiennych, od których zależy wielomian
+} PolyTape;
+
+/**
+ * Kompiluje wielomian do taśmy. Wielomian nie jest zmieniany i nie musi
+ * istnieć po kompilacji.
+ * @param[in] p : wielomian
+ * @return taśma obliczająca wartość @p p
+ */
+PolyTape PolyCompileEval(const Poly *p);
+
+/**
+ * Oblicza wartość skompilowanego wielomianu, podstawiając pod zmienne
+ * @f$x_0, \ldots, x_{k-1}@f$ współczynniki @f$q_0, \ldots, q_{k-1}@f$,
+ * a pod pozostałe zmienne zera. Wynik jest taki sam jak wynik PolyCompose
+ * dla tych samych argumentów.
+ * @param[in, out] tape : taśma, jej tablice robocze są nadpisywane
+ * @param[in] k : liczba podstawianych wartości
+ * @param[in] q : tablica @p k wielomianów będących współczynnikami
+ * @return wartość wielomianu
+ */
+poly_coeff_t PolyTapeEval(PolyTape *tape, size_t k, const Poly q[]);
+
+/**
+ * Usuwa taśmę z pamięci.
+ * @param[in, out] tape : taśma
+ */
+void PolyTapeDestroy(PolyTape *tape);
+
+#endif /* POLY_TAPE_H */
@@ -3,6 +3,7 @@
 #endif
 
 #include "poly.h"
+#include "poly_tape.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -2894,6 +2895,31 @@ static bool TestAdd(Poly a, Poly b, Poly res) {
   return TestOpCopy(a, b, res, PolyAdd);
 }
 
+static bool TestAddTo(Poly a, Poly b, Poly res) {
+  PolyAddTo(&a, &b);
+  bool is_eq = PolyIsEq(&a, &res) && PolyIsZero(&b);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&res);
+  return is_eq;
+}
+
+static bool TestSubTo(Poly a, Poly b, Poly res) {
+  // Kopia dzieli tablice z odjemnikiem i nie może zmienić się razem z nim.
+  Poly copy = PolyClone(&b);
+  Poly negated = PolyNeg(&b);
+  PolySubTo(&a, &b);
+  Poly sum = PolyAdd(&copy, &negated);
+  bool is_eq = PolyIsEq(&a, &res) && PolyIsZero(&b) && PolyIsZero(&sum);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&copy);
+  PolyDestroy(&negated);
+  PolyDestroy(&sum);
+  PolyDestroy(&res);
+  return is_eq;
+}
+
 static bool TestAddMonos(size_t count, Mono monos[], Poly res) {
   Poly b = PolyAddMonos(count, monos);
   bool is_eq = PolyIsEq(&b, &res);
@@ -3009,6 +3035,49 @@ static bool SimpleAddTest(void) {
   return res;
 }
 
+static bool SimpleAddToTest(void) {
+  bool res = true;
+  res &= TestAddTo(C(1),
+                   C(2),
+                   C(3));
+  res &= TestAddTo(P(C(1), 1),
+                   C(2),
+                   P(C(2), 0, C(1), 1));
+  res &= TestAddTo(C(1),
+                   P(C(2), 2),
+                   P(C(1), 0, C(2), 2));
+  res &= TestAddTo(P(C(1), 0, C(1), 1),
+                   C(-1),
+                   P(C(1), 1));
+  res &= TestAddTo(P(C(1), 1, C(2), 3, C(3), 5),
+                   P(C(4), 0, C(-2), 3, C(5), 4, C(6), 6),
+                   P(C(4), 0, C(1), 1, C(5), 4, C(3), 5, C(6), 6));
+  res &= TestAddTo(P(C(1), 0, C(1), 2),
+                   P(C(-1), 2),
+                   C(1));
+  res &= TestAddTo(P(C(1), 1, C(1), 2),
+                   P(C(-1), 1, C(-1), 2),
+                   C(0));
+  res &= TestAddTo(P(P(C(1), 1), 1, C(1), 2),
+                   P(P(C(-1), 1, C(1), 2), 1, C(1), 3),
+                   P(P(C(1), 2), 1, C(1), 2, C(1), 3));
+  return res;
+}
+
+static bool SimpleInternTest(void) {
+  bool res = true;
+  Poly a = PolyIntern(P(P(C(1), 1, C(2), 2), 1, C(3), 2));
+  Poly b = PolyIntern(P(P(C(1), 1, C(2), 2), 1, C(3), 2));
+  Poly c = PolyIntern(P(P(C(1), 1, C(2), 2), 2));
+  res &= a.arr == b.arr;
+  res &= PolyIsEq(&a, &b);
+  res &= !PolyIsEq(&a, &c);
+  res &= a.arr[0].p.arr == c.arr[0].p.arr;
+  res &= TestAdd(a, c, P(P(C(1), 1, C(2), 2), 1, P(C(3), 0, C(1), 1, C(2), 2), 2));
+  PolyDestroy(&b);
+  return res;
+}
+
 static bool SimpleAddMonosTest(void) {
   bool res = true;
   {
@@ -3040,6 +3109,57 @@ static bool SimpleAddMonosTest(void) {
                 M(P(C(2), 2), 2)};
     res &= TestAddMonos(6, m, P(C(2), 0, C(1), 1, P(C(2), 1, C(2), 2), 2));
   }
+  {
+    Mono m[1000];
+    Mono sorted[500];
+    for (poly_exp_t i = 0; i < 1000; i++)
+      m[i] = M(C(1), (499 - i % 500) * 65537);
+    for (poly_exp_t i = 0; i < 500; i++)
+      sorted[i] = M(C(2), i * 65537);
+    res &= TestAddMonos(1000, m, PolyAddMonos(500, sorted));
+  }
+  return res;
+}
+
+static bool SimpleBuilderTest(void) {
+  bool res = true;
+  PolyBuilder builder = PolyBuilderCreate(0);
+  Poly p = PolyBuilderFinish(&builder);
+  res &= PolyIsZero(&p);
+
+  Mono m[] = {M(C(1), 0), M(P(C(1), 1), 2), M(C(0), 3), M(C(5), 4)};
+  for (size_t i = 0; i < sizeof(m) / sizeof(m[0]); i++)
+    PolyBuilderAppend(&builder, &m[i]);
+  p = PolyBuilderFinish(&builder);
+  res &= TestEq(p, P(C(1), 0, P(C(1), 1), 2, C(5), 4), true);
+
+  Mono n[] = {M(C(2), 3), M(C(1), 0), M(C(-2), 3), M(P(C(1), 1), 5),
+              M(C(-1), 0), M(P(C(1), 2), 5)};
+  for (size_t i = 0; i < sizeof(n) / sizeof(n[0]); i++)
+    PolyBuilderAppend(&builder, &n[i]);
+  p = PolyBuilderFinish(&builder);
+  res &= TestEq(p, P(P(C(1), 1, C(1), 2), 5), true);
+
+  for (poly_exp_t i = 0; i < 100; i++) {
+    Mono k = M(C(i), i);
+    PolyBuilderAppend(&builder, &k);
+  }
+  PolyBuilderDestroy(&builder);
+  p = PolyBuilderFinish(&builder);
+  res &= PolyIsZero(&p);
+
+  // Długie nieposortowane wejście z zerami i powtórzonymi wykładnikami
+  // daje ten sam wielomian co PolyAddMonos.
+  Mono k[300];
+  builder = PolyBuilderCreate(1);
+  for (size_t i = 0; i < sizeof(k) / sizeof(k[0]); i++) {
+    k[i] = M(P(C((poly_coeff_t)(i % 7) - 3), (poly_exp_t)(i % 5)),
+             (poly_exp_t)(i * 37 % 101));
+    Mono copy = MonoClone(&k[i]);
+    PolyBuilderAppend(&builder, &copy);
+  }
+  p = PolyBuilderFinish(&builder);
+  res &= TestEq(p, PolyAddMonos(sizeof(k) / sizeof(k[0]), k), true);
   return res;
 }
 
@@ -3066,6 +3186,124 @@ static bool SimpleMulTest(void) {
   res &= TestMul(P(P(C(1), 2), 0, P(C(1), 1), 1, C(1), 2),
                  P(P(C(1), 2), 0, P(C(-1), 1), 1, C(1), 2),
                  P(P(C(1), 4), 0, P(C(1), 2), 2, C(1), 4));
+  // Stała nad zmienną x_2 nie może zaniżyć ograniczenia jej wykładnika
+  // przy upakowaniu wykładników.
+  res &= TestMul(P(P(P(C(1), 7), 0, C(1), 1), 0, C(3), 2),
+                 P(P(P(C(1), 7), 0, C(1), 1), 0, C(3), 2),
+                 P(P(P(C(1), 14), 0, P(C(2), 7), 1, C(1), 2), 0,
+                   P(P(C(6), 7), 0, C(6), 1), 2, C(9), 4));
+  return res;
+}
+
+/**
+ * Mnoży wielomiany jednomian po jednomianie i sumuje iloczyny. Czynniki
+ * każdego iloczynu mają po jednym jednomianie, więc PolyMul liczy je
+ * scalaniem kopcem. Wynik jest wzorcem dla szybszych algorytmów mnożenia.
+ * @param a pierwszy czynnik
+ * @param b drugi czynnik
+ */
+static Poly TermwiseMul(const Poly *a, const Poly *b) {
+  if (PolyIsCoeff(a) || PolyIsCoeff(b))
+    return PolyMul(a, b);
+  Poly result = PolyZero();
+  for (size_t i = 0; i < a->size; i++) {
+    for (size_t j = 0; j < b->size; j++) {
+      Poly ma = PolyCloneMonos(1, &a->arr[i]);
+      Poly mb = PolyCloneMonos(1, &b->arr[j]);
+      Poly product = PolyMul(&ma, &mb);
+      PolyAddTo(&result, &product);
+      PolyDestroy(&ma);
+      PolyDestroy(&mb);
+    }
+  }
+  return result;
+}
+
+/**
+ * Współczynniki z pełnego zakresu 64 bitów, których iloczyny i sumy
+ * przekraczają zakres modułów NTT.
+ */
+static const poly_coeff_t WIDE_COEFFS[] = {
+  LONG_MAX, -LONG_MAX, LONG_MIN, 1, -1, 0x5DEECE66DL, -0x123456789ABCDEFL,
+  LONG_MAX - 12345
+};
+
+/**
+ * Tworzy wielomian @f$\sum_{i < count} c_i x^{i \cdot step} q@f$
+ * o współczynnikach @f$c_i@f$ z tablicy WIDE_COEFFS.
+ * @param count liczba jednomianów
+ * @param step odstęp między wykładnikami
+ * @param shift przesunięcie w tablicy współczynników
+ * @param coeff wielomian @f$q@f$, przez który mnożone są współczynniki
+ */
+static Poly MakeWidePoly(size_t count, poly_exp_t step, size_t shift,
+                         const Poly *coeff) {
+  size_t n = sizeof(WIDE_COEFFS) / sizeof(WIDE_COEFFS[0]);
+  PolyBuilder builder = PolyBuilderCreate(count);
+  for (size_t i = 0; i < count; i++) {
+    Poly c = PolyFromCoeff(WIDE_COEFFS[(7 * i + shift) % n]);
+    Poly p = PolyMul(&c, coeff);
+    Mono m = MonoFromPoly(&p, (poly_exp_t)i * step);
+    PolyBuilderAppend(&builder, &m);
+  }
+  return PolyBuilderFinish(&builder);
+}
+
+/**
+ * Porównuje iloczyn PolyMul z iloczynem liczonym jednomian po jednomianie.
+ * @param a pierwszy czynnik
+ * @param b drugi czynnik
+ */
+static bool TestMulTermwise(Poly a, Poly b) {
+  Poly fast = PolyMul(&a, &b);
+  Poly slow = TermwiseMul(&a, &b);
+  bool is_eq = PolyIsEq(&fast, &slow);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&fast);
+  PolyDestroy(&slow);
+  return is_eq;
+}
+
+static bool NttMulTest(void) {
+  // Gęste czynniki powyżej NTT_MIN_TERMS jednomianów mnożone są za pomocą
+  // NTT, a wynik modulo 2^64 odtwarzany algorytmem Garnera.
+  bool res = true;
+  Poly one = C(1);
+  res &= TestMulTermwise(MakeWidePoly(200, 1, 0, &one),
+                         MakeWidePoly(150, 1, 3, &one));
+  res &= TestMulTermwise(MakeWidePoly(256, 1, 1, &one),
+                         MakeWidePoly(100, 1, 5, &one));
+  res &= TestMulTermwise(MakeWidePoly(300, 1, 2, &one),
+                         MakeWidePoly(300, 1, 2, &one));
+
+  // Kwadrat liczony jest jedną transformatą.
+  Poly p = MakeWidePoly(257, 1, 4, &one);
+  Poly square = PolyMul(&p, &p);
+  Poly expected = TermwiseMul(&p, &p);
+  res &= PolyIsEq(&square, &expected);
+  PolyDestroy(&p);
+  PolyDestroy(&square);
+  PolyDestroy(&expected);
+  return res;
+}
+
+static bool KaratsubaMulTest(void) {
+  // Rzadkie współczynniki 1 + y^1000 wykluczają NTT, więc gęste czynniki
+  // podobnej długości mnożone są algorytmem Karatsuby. Nieparzyste długości
+  // sprawdzają podział na połowy różnej długości.
+  bool res = true;
+  Poly sparse = P(C(1), 0, C(1), 1000);
+  Poly one = C(1);
+  res &= TestMulTermwise(MakeWidePoly(33, 1, 0, &sparse),
+                         MakeWidePoly(33, 1, 1, &sparse));
+  res &= TestMulTermwise(MakeWidePoly(37, 1, 2, &sparse),
+                         MakeWidePoly(45, 1, 3, &sparse));
+  res &= TestMulTermwise(MakeWidePoly(63, 1, 4, &sparse),
+                         MakeWidePoly(64, 1, 5, &sparse));
+  res &= TestMulTermwise(MakeWidePoly(129, 1, 1, &one),
+                         MakeWidePoly(129, 1, 5, &one));
+  PolyDestroy(&sparse);
   return res;
 }
 
@@ -3086,6 +3324,26 @@ static bool SimpleSubTest(void) {
                  P(P(C(1), 0, C(4), 1, C(1), 2), 1));
 }
 
+static bool SimpleSubToTest(void) {
+  bool res = true;
+  res &= TestSubTo(C(1),
+                   C(2),
+                   C(-1));
+  res &= TestSubTo(C(1),
+                   P(C(2), 2),
+                   P(C(1), 0, C(-2), 2));
+  res &= TestSubTo(P(C(1), 1, C(2), 3),
+                   P(C(1), 1, C(-2), 4),
+                   P(C(2), 3, C(2), 4));
+  res &= TestSubTo(P(P(C(1), 1), 1, C(1), 2),
+                   P(P(C(1), 1), 1, C(1), 2),
+                   C(0));
+  res &= TestSubTo(P(P(C(1), 2), 0, P(C(2), 1), 1, C(1), 2),
+                   P(P(C(1), 2), 0, P(C(-1), 0, C(-2), 1, C(-1), 2), 1, C(1), 2),
+                   P(P(C(1), 0, C(4), 1, C(1), 2), 1));
+  return res;
+}
+
 #define POLY_P P(P(C(1), 3), 0, P(C(1), 2), 2, C(1), 3)
 
 static bool SimpleDegByTest(void) {
@@ -3095,6 +3353,8 @@ static bool SimpleDegByTest(void) {
   res &= TestDegBy(P(C(1), 1), 1, 0);
   res &= TestDegBy(POLY_P, 0, 3);
   res &= TestDegBy(POLY_P, 1, 3);
+  // Stała na wyższym poziomie nie zeruje stopnia znalezionego wcześniej.
+  res &= TestDegBy(P(P(P(C(1), 7), 0, C(1), 1), 0, C(3), 2), 2, 7);
   return res;
 }
 
@@ -3137,6 +3397,163 @@ static bool SimpleAtTest(void) {
   return res;
 }
 
+static bool TestAtMany(const Poly *p, size_t n, const poly_coeff_t *xs) {
+  bool res = true;
+  Poly *results = malloc(n * sizeof(Poly));
+  assert(results);
+  PolyAtMany(p, n, xs, results);
+  for (size_t i = 0; i < n; ++i) {
+    Poly expected = PolyAt(p, xs[i]);
+    res &= PolyIsEq(&results[i], &expected);
+    PolyDestroy(&expected);
+    PolyDestroy(&results[i]);
+  }
+  free(results);
+  return res;
+}
+
+static bool SimpleAtManyTest(void) {
+  bool res = true;
+  poly_coeff_t xs[] = {0, 1, -1, 2, 10, -7, 1L << 40};
+  size_t n = sizeof(xs) / sizeof(xs[0]);
+  Poly p = P(C(3), 1, C(2), 3, C(1), 5);
+  res &= TestAtMany(&p, n, xs);
+  PolyDestroy(&p);
+  p = P(P(C(1), 4), 0, P(C(1), 2), 2, C(1), 3);
+  res &= TestAtMany(&p, n, xs);
+  PolyDestroy(&p);
+  p = C(5);
+  res &= TestAtMany(&p, n, xs);
+  PolyDestroy(&p);
+
+  // Punktów więcej niż w jednym bloku, w tym zero zerujące wagi.
+  poly_coeff_t many[150];
+  size_t many_count = sizeof(many) / sizeof(many[0]);
+  for (size_t i = 0; i < many_count; ++i)
+    many[i] = (poly_coeff_t)(i * 0x9E3779B97F4A7C15ULL) - 75;
+  many[100] = 0;
+  p = P(P(C(1), 4), 0, P(C(-2), 1, C(1), 2), 2, C(LONG_MAX), 3,
+        P(P(C(1), 1), 0, C(3), 5), 9);
+  res &= TestAtMany(&p, many_count, many);
+  PolyDestroy(&p);
+  p = P(C(3), 1, C(LONG_MIN), 3, C(1), 5, C(-7), 40);
+  res &= TestAtMany(&p, many_count, many);
+  PolyDestroy(&p);
+
+  // Wielomian i punkty na tyle duże, by użyć drzewa iloczynów.
+  size_t count = 10000;
+  Mono *monos = malloc(count * sizeof(Mono));
+  poly_coeff_t *points = malloc(count * sizeof(poly_coeff_t));
+  assert(monos && points);
+  for (size_t i = 0; i < count; ++i) {
+    poly_coeff_t c = (poly_coeff_t)(i * 0x9E3779B97F4A7C15ULL);
+    monos[i] = M(C(c == 0 ? 1 : c), (poly_exp_t)i);
+    points[i] = (poly_coeff_t)((i + 1) * 0xC2B2AE3D27D4EB4FULL);
+  }
+  p = PolyAddMonos(count, monos);
+  res &= TestAtMany(&p, count, points);
+  PolyDestroy(&p);
+  free(monos);
+  free(points);
+  return res;
+}
+
+static bool TestCompileEval(Poly p, size_t k, const poly_coeff_t *xs) {
+  Poly q[4];
+  assert(k <= sizeof(q) / sizeof(q[0]));
+  for (size_t i = 0; i < k; ++i)
+    q[i] = PolyFromCoeff(xs[i]);
+  Poly expected = PolyCompose(&p, k, q);
+  PolyTape tape = PolyCompileEval(&p);
+  // Taśma może być obliczana wielokrotnie.
+  bool res = PolyIsCoeff(&expected) &&
+             PolyTapeEval(&tape, k, q) == expected.coeff &&
+             PolyTapeEval(&tape, k, q) == expected.coeff;
+  PolyTapeDestroy(&tape);
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  return res;
+}
+
+static bool SimpleCompileEvalTest(void) {
+  bool res = true;
+  poly_coeff_t xs[] = {3, -2, 1L << 40, 7};
+  res &= TestCompileEval(C(5), 2, xs);
+  res &= TestCompileEval(P(C(3), 1, C(2), 3, C(1), 5), 1, xs);
+  res &= TestCompileEval(P(P(C(1), 4), 0, P(C(1), 2), 2, C(1), 3), 2, xs);
+  res &= TestCompileEval(P(P(C(1), 4), 0, P(C(1), 2), 2, C(1), 3), 1, xs);
+  res &= TestCompileEval(P(P(P(C(1), 0, C(2), 64), 1), 2, C(-1), 70), 4, xs);
+  res &= TestCompileEval(P(P(P(C(1), 0, C(2), 3), 1), 2, C(-1), 7), 0, xs);
+  return res;
+}
+
+static bool TestTermCount(Poly a, size_t res) {
+  bool is_eq = PolyTermCount(&a) == res;
+  PolyDestroy(&a);
+  return is_eq;
+}
+
+static bool SimpleTermCountTest(void) {
+  bool res = true;
+  res &= TestTermCount(C(0), 0);
+  res &= TestTermCount(C(5), 1);
+  res &= TestTermCount(POLY_P, 3);
+
+  Mono monos[20];
+  for (size_t i = 0; i < sizeof(monos) / sizeof(monos[0]); i++) {
+    Poly c = P(C(1), 0, C(1), 1);
+    monos[i] = MonoFromPoly(&c, (poly_exp_t) i);
+  }
+  Poly p = PolyCloneMonos(sizeof(monos) / sizeof(monos[0]), monos);
+  res &= PolyTermCount(&p) == 40;
+  res &= PolyDeg(&p) == 20;
+  res &= PolyDegBy(&p, 0) == 19 && PolyDegBy(&p, 1) == 1;
+
+  Poly q = PolyClone(&p);
+  Poly m = P(C(1), 25);
+  PolyAddTo(&p, &m);
+  res &= PolyTermCount(&p) == 41 && PolyDeg(&p) == 25;
+  res &= PolyTermCount(&q) == 40 && PolyDeg(&q) == 20;
+  res &= !PolyIsEq(&p, &q);
+  PolyDestroy(&q);
+
+  m = P(C(1), 30);
+  PolyAddTo(&p, &m);
+  res &= PolyTermCount(&p) == 42 && PolyDeg(&p) == 30;
+  m = P(C(-1), 25, C(-1), 30);
+  PolyAddTo(&p, &m);
+  q = PolyAddMonos(sizeof(monos) / sizeof(monos[0]), monos);
+  res &= PolyIsEq(&p, &q);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+
+  // Metadane zapamiętane przy tworzeniu tablicy są usuwane, gdy tablica
+  // zmieniana jest w miejscu, np. przy negacji odjemnika.
+  for (size_t i = 0; i < sizeof(monos) / sizeof(monos[0]); i++) {
+    Poly c = P(C(1), 0, C((poly_coeff_t) i + 1), 1);
+    monos[i] = MonoFromPoly(&c, (poly_exp_t) i);
+  }
+  p = PolyCloneMonos(sizeof(monos) / sizeof(monos[0]), monos);
+  q = PolyAddMonos(sizeof(monos) / sizeof(monos[0]), monos);
+  res &= PolyIsEq(&p, &q);
+  Poly difference = PolyZero();
+  PolySubTo(&difference, &q);
+  Poly neg = PolyNeg(&p);
+  res &= !PolyIsEq(&difference, &p) && PolyIsEq(&difference, &neg);
+  PolyDestroy(&difference);
+  PolyDestroy(&neg);
+  PolyDestroy(&p);
+
+  p = C(1);
+  for (poly_exp_t i = 0; i < 10; i++) {
+    p = P(p, i + 1);
+  }
+  res &= PolyDegBy(&p, 9) == 1 && PolyDegBy(&p, 0) == 10;
+  res &= PolyDegBy(&p, 10) == 0 && PolyDeg(&p) == 55;
+  PolyDestroy(&p);
+  return res;
+}
+
 static bool OverflowTest(void) {
   bool res = true;
   res &= TestMul(P(C(1L << 32), 1), C(1L << 32), C(0));
@@ -3413,6 +3830,60 @@ static Poly MakePolyFromPolynomials(size_t count, const Poly *val,
   return res;
 }
 
+/**
+ * Porównuje kwadrat wielomianu z iloczynem dwóch jego niezależnych kopii.
+ * @param a wielomian
+ * @param b wielomian równy @p a, ale z osobnymi tablicami jednomianów
+ */
+static bool TestSqr(Poly a, Poly b) {
+  Poly sqr = PolySqr(&a);
+  Poly mul = PolyMul(&a, &b);
+  bool is_eq = PolyIsEq(&sqr, &mul);
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&sqr);
+  PolyDestroy(&mul);
+  return is_eq;
+}
+
+static bool SimpleSqrTest(void) {
+  bool res = true;
+  Poly p = C(-3);
+  Poly sqr = PolySqr(&p);
+  res &= PolyIsCoeff(&sqr) && sqr.coeff == 9;
+  p = P(C(1), 0, C(1), 1);
+  sqr = PolySqr(&p);
+  Poly expected = P(C(1), 0, C(2), 1, C(1), 2);
+  res &= PolyIsEq(&sqr, &expected);
+  PolyDestroy(&p);
+  PolyDestroy(&sqr);
+  PolyDestroy(&expected);
+  // Podwojone iloczyny mogą się zerować modulo 2^64.
+  res &= TestSqr(P(C(1L << 62), 0, C(1L << 62), 1, C(3), 2),
+                 P(C(1L << 62), 0, C(1L << 62), 1, C(3), 2));
+  res &= TestSqr(P(P(C(1), 2), 0, P(C(-1), 1), 1, C(1), 2),
+                 P(P(C(1), 2), 0, P(C(-1), 1), 1, C(1), 2));
+
+  // Kolejne przypadki sprawdzają NTT, scalanie kopcem po upakowaniu
+  // wykładników, algorytm Karatsuby i scalanie kopcem bez upakowania.
+  Poly one = C(1);
+  Poly sparse = P(C(1), 0, C(1), 1000);
+  Poly huge = P(C(3), 1, P(C(2), 0, C(1), 1 << 29), 1 << 29);
+  const struct {
+    size_t count;
+    poly_exp_t step;
+    const Poly *coeff;
+  } cases[] = {{300, 1, &one}, {50, 37, &one}, {40, 1, &sparse}, {20, 1 << 24, &huge}};
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    res &= TestSqr(
+        MakeWidePoly(cases[i].count, cases[i].step, i, cases[i].coeff),
+        MakeWidePoly(cases[i].count, cases[i].step, i, cases[i].coeff));
+  }
+  PolyDestroy(&sparse);
+  PolyDestroy(&huge);
+  return res;
+}
+
 /**
  * Buduje wielomian o określonej głębokości. Pobiera długość kolejnych
  * wielomianów z tablicy exp_arr i wykładniki z tablicy exp_arr1.
@@ -4018,15 +4489,25 @@ typedef struct {
 static const test_list_t test_list[] = {
   TEST(SimpleAddTest),
   TEST(SimpleAddMonosTest),
+  TEST(SimpleBuilderTest),
+  TEST(SimpleAddToTest),
+  TEST(SimpleInternTest),
   TEST(SimpleMulTest),
+  TEST(NttMulTest),
+  TEST(KaratsubaMulTest),
+  TEST(SimpleSqrTest),
   TEST(SimpleNegTest),
   TEST(SimpleSubTest),
+  TEST(SimpleSubToTest),
   TEST(SimpleNegGroup),
   TEST(SimpleDegByTest),
   TEST(SimpleDegTest),
   TEST(SimpleDegGroup),
   TEST(SimpleIsEqTest),
   TEST(SimpleAtTest),
+  TEST(SimpleAtManyTest),
+  TEST(SimpleCompileEvalTest),
+  TEST(SimpleTermCountTest),
   TEST(OverflowTest),
   TEST(SimpleArithmeticTest),
   TEST(LongPolynomialTest),
@@ -0,0 +1,706 @@
+/** @file
+ *  Implementacja kompilacji skryptu kalkulatora, maszyny wykonującej
+ *  skompilowany program oraz zapisu programu w pamięci podręcznej
+ *  @author Patrycja Stępień
+*/
+
+/**
+ * Makro potrzebne do korzystania z funkcji POSIX: mmap i odczytu czasu
+ * modyfikacji pliku (st_mtim).
+ */
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "program.h"
+#include "instructions.h"
+#include "output.h"
+#include "poly_alloc.h"
+#include "poly_execute.h"
+#include "read_input.h"
+
+/**
+ * Początkowy rozmiar tablicy instrukcji i puli stałych.
+ */
+#define PROGRAM_INIT_CAPACITY 16
+
+/**
+ * Znacznik formatu pliku pamięci podręcznej, zmieniany przy każdej
+ * zmianie formatu lub kodów instrukcji.
+ */
+#define CACHE_MAGIC "POLYPRG2"
+
+/**
+ * Wartość kontrolna zapisywana w nagłówku. Plik zapisany na maszynie
+ * o innej kolejności bajtów ma w tym miejscu inną wartość.
+ */
+#define CACHE_BYTE_ORDER 0x0102030405060708ULL
+
+/**
+ * Początkowy rozmiar bufora zapisu pliku pamięci podręcznej.
+ */
+#define CACHE_WRITER_INIT_CAPACITY 4096
+
+/**
+ * Liczba bitów wartości zapisywanych w jednym bajcie liczby o zmiennej
+ * długości. Najstarszy bit bajtu oznacza, że liczba ma kolejne bajty.
+ */
+#define VARINT_BITS 7
+
+/**
+ * Najdłuższy zapis liczby 64-bitowej o zmiennej długości.
+ */
+#define VARINT_MAX_BYTES 10
+
+/**
+ * Wersja skryptu, dla której zapisano program: rozmiar i czas ostatniej
+ * modyfikacji pliku.
+ */
+typedef struct ScriptStamp {
+    uint64_t size; ///< rozmiar skryptu w bajtach
+    int64_t seconds; ///< czas modyfikacji, sekundy
+    int64_t nanoseconds; ///< czas modyfikacji, nanosekundy
+} ScriptStamp;
+
+/**
+ * Nagłówek pliku pamięci podręcznej. Za nim zapisane są kolejno stałe
+ * i instrukcje programu, liczby w zapisie o zmiennej długości.
+ */
+typedef struct CacheHeader {
+    char magic[8]; ///< znacznik formatu CACHE_MAGIC
+    uint64_t byteOrder; ///< wartość kontrolna CACHE_BYTE_ORDER
+    ScriptStamp stamp; ///< wersja skryptu
+    uint64_t constantsSize; ///< rozmiar puli stałych w bajtach
+    uint64_t size; ///< liczba instrukcji
+} CacheHeader;
+
+/**
+ * Bufor, w którym składany jest plik pamięci podręcznej.
+ */
+typedef struct CacheWriter {
+    unsigned char* data; ///< zapisane bajty
+    size_t size; ///< liczba zapisanych bajtów
+    size_t capacity; ///< rozmiar bufora
+} CacheWriter;
+
+/**
+ * Stan odczytu pliku pamięci podręcznej odwzorowanego w pamięci.
+ */
+typedef struct CacheReader {
+    const unsigned char* pos; ///< bieżący bajt
+    const unsigned char* end; ///< pierwszy bajt za danymi
+} CacheReader;
+
+/**
+ * Tworzy pusty bufor zapisu.
+ * @return pusty bufor zapisu
+ */
+static CacheWriter CacheWriterCreate(void) {
+    CacheWriter writer = {.size = 0, .capacity = CACHE_WRITER_INIT_CAPACITY};
+    writer.data = malloc(writer.capacity);
+    if (writer.data == NULL) {
+        exit(1);
+    }
+    return writer;
+}
+
+/**
+ * Dopisuje bajty do bufora zapisu.
+ * @param[in, out] writer : bufor zapisu
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ */
+static void WriteBytes(CacheWriter* writer, const void* data, size_t size) {
+    if (writer->capacity - writer->size < size) {
+        while (writer->capacity - writer->size < size) {
+            writer->capacity *= 2;
+        }
+        writer->data = realloc(writer->data, writer->capacity);
+        if (writer->data == NULL) {
+            exit(1);
+        }
+    }
+    memcpy(writer->data + writer->size, data, size);
+    writer->size += size;
+}
+
+/**
+ * Dopisuje liczbę w zapisie o zmiennej długości: po @ref VARINT_BITS
+ * bitów na bajt, od najmłodszych.
+ * @param[in, out] writer : bufor zapisu
+ * @param[in] value : liczba
+ */
+static void WriteVarint(CacheWriter* writer, uint64_t value) {
+    unsigned char bytes[VARINT_MAX_BYTES];
+    size_t size = 0;
+    while (value >= 0x80) {
+        bytes[size++] = (unsigned char) (value | 0x80);
+        value >>= VARINT_BITS;
+    }
+    bytes[size++] = (unsigned char) value;
+    WriteBytes(writer, bytes, size);
+}
+
+/**
+ * Zapisuje wielomian: liczbę jednomianów, a dla współczynnika zero
+ * i wartość współczynnika. Wykładniki jednomianów rosną, więc zapisywane
+ * są różnice kolejnych wykładników. Współczynniki zapisywane są tak, żeby
+ * liczby o małej wartości bezwzględnej zajmowały mało bajtów.
+ * @param[in, out] writer : bufor zapisu
+ * @param[in] p : wielomian
+ */
+static void WritePoly(CacheWriter* writer, const Poly* p) {
+    if (PolyIsCoeff(p)) {
+        uint64_t coeff = (uint64_t) p->coeff;
+        WriteVarint(writer, 0);
+        WriteVarint(writer, (coeff << 1) ^ (p->coeff < 0 ? UINT64_MAX : 0));
+        return;
+    }
+    WriteVarint(writer, p->size);
+    poly_exp_t prev = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        WriteVarint(writer, (uint64_t) (p->arr[i].exp - prev));
+        prev = p->arr[i].exp;
+        WritePoly(writer, &(p->arr[i].p));
+    }
+}
+
+/**
+ * Odczytuje zadaną liczbę bajtów.
+ * @param[in, out] reader : stan odczytu
+ * @param[out] out : odczytane bajty
+ * @param[in] size : liczba bajtów
+ * @return czy w danych było dość bajtów
+ */
+static bool ReadBytes(CacheReader* reader, void* out, size_t size) {
+    if ((size_t) (reader->end - reader->pos) < size) {
+        return false;
+    }
+    memcpy(out, reader->pos, size);
+    reader->pos += size;
+    return true;
+}
+
+/**
+ * Odczytuje liczbę zapisaną przez WriteVarint.
+ * @param[in, out] reader : stan odczytu
+ * @param[out] value : odczytana liczba
+ * @return czy odczytano poprawną liczbę
+ */
+static bool ReadVarint(CacheReader* reader, uint64_t* value) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < VARINT_MAX_BYTES * VARINT_BITS; shift += VARINT_BITS) {
+        if (reader->pos == reader->end) {
+            return false;
+        }
+        unsigned char byte = *(reader->pos)++;
+        result |= (uint64_t) (byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Odczytuje wielomian zapisany przez WritePoly. Jednomiany są dodawane
+ * przez PolyBuilder, więc nawet uszkodzony plik daje poprawny wielomian.
+ * @param[in, out] reader : stan odczytu
+ * @param[out] result : odczytany wielomian
+ * @return czy odczytano wielomian
+ */
+static bool ReadPoly(CacheReader* reader, Poly* result) {
+    uint64_t size;
+    if (!ReadVarint(reader, &size)) {
+        return false;
+    }
+    if (size == 0) {
+        uint64_t coeff;
+        if (!ReadVarint(reader, &coeff)) {
+            return false;
+        }
+        *result = PolyFromCoeff((poly_coeff_t) ((coeff >> 1) ^ (0 - (coeff & 1))));
+        return true;
+    }
+    // Każdy jednomian zajmuje co najmniej trzy bajty.
+    if ((size_t) (reader->end - reader->pos) / 3 < size) {
+        return false;
+    }
+
+    PolyBuilder builder = PolyBuilderCreate(size);
+    uint64_t exp = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        uint64_t delta;
+        Poly p;
+        if (!ReadVarint(reader, &delta) || delta > INT32_MAX - exp || !ReadPoly(reader, &p)) {
+            PolyBuilderDestroy(&builder);
+            return false;
+        }
+        exp += delta;
+        Mono m = MonoFromPoly(&p, (poly_exp_t) exp);
+        PolyBuilderAppend(&builder, &m);
+    }
+    *result = PolyBuilderFinish(&builder);
+    return true;
+}
+
+/**
+ * Tworzy pusty program.
+ * @return pusty program
+ */
+static Program ProgramCreate(void) {
+    Program program = {.size = 0, .capacity = PROGRAM_INIT_CAPACITY, .constants = NULL,
+                       .constantsSize = 0, .storage = NULL, .mappedSize = 0};
+    program.code = PolyMalloc(program.capacity * sizeof(ProgramOp));
+    return program;
+}
+
+void ProgramDestroy(Program* program) {
+    if (program->mappedSize > 0) {
+        munmap(program->storage, program->mappedSize);
+    } else {
+        free(program->storage);
+    }
+    PolyFree(program->code);
+    *program = (Program) {.code = NULL, .size = 0, .capacity = 0, .constants = NULL,
+                          .constantsSize = 0, .storage = NULL, .mappedSize = 0};
+}
+
+/**
+ * Dopisuje instrukcję na koniec programu.
+ * @param[in, out] program : program
+ * @param[in] code : kod instrukcji
+ * @param[in] lineNumber : numer wiersza skryptu
+ * @param[in] arg : parametr instrukcji
+ */
+static void Emit(Program* program, uint32_t code, int lineNumber, uint64_t arg) {
+    if (program->size == program->capacity) {
+        program->capacity *= 2;
+        program->code = PolyRealloc(program->code, program->capacity * sizeof(ProgramOp));
+    }
+    program->code[(program->size)++] = (ProgramOp) {
+        .code = code, .lineNumber = lineNumber, .arg = arg};
+}
+
+/**
+ * Stan kompilacji skryptu.
+ */
+typedef struct Compiler {
+    Program program; ///< kompilowany program
+    CacheWriter constants; ///< zakodowane stałe
+} Compiler;
+
+/**
+ * Kompiluje wiersz z poleceniem do instrukcji programu.
+ * @param[in, out] compiler : stan kompilacji
+ * @param[in] line : wiersz z poleceniem
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[in] lineNumber : numer wiersza
+ */
+static void CompileInstruction(void* compiler, char const* line, size_t lineSize, int lineNumber) {
+    Program* program = &(((Compiler*) compiler)->program);
+    Command command = InstructionDecode(line, lineSize);
+    if (command.correct) {
+        Emit(program, command.id, lineNumber, command.param);
+    } else {
+        Emit(program, OP_ERROR, lineNumber, command.id);
+    }
+}
+
+/**
+ * Kompiluje wiersz z wielomianem: parsuje go i dopisuje do puli stałych.
+ * @param[in, out] compiler : stan kompilacji
+ * @param[in] line : wiersz z wielomianem
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[in] lineNumber : numer wiersza
+ */
+static void CompilePoly(void* compiler, char const* line, size_t lineSize, int lineNumber) {
+    Compiler* state = compiler;
+    Poly p;
+    if (PolyParse(line, lineSize, &p)) {
+        Emit(&(state->program), OP_PUSH, lineNumber, state->constants.size);
+        WritePoly(&(state->constants), &p);
+        PolyDestroy(&p);
+    } else {
+        Emit(&(state->program), OP_WRONG_POLY, lineNumber, 0);
+    }
+}
+
+/**
+ * Obsługa wierszy kompilująca je do programu.
+ */
+static const LineHandlers COMPILE_HANDLERS = {
+    .instruction = CompileInstruction,
+    .poly = CompilePoly
+};
+
+bool ProgramCompileFile(Program* program, char const* path) {
+    Compiler compiler = {.program = ProgramCreate(), .constants = CacheWriterCreate()};
+    bool opened = ReadFileLines(path, &COMPILE_HANDLERS, &compiler);
+    *program = compiler.program;
+    program->storage = compiler.constants.data;
+    program->constants = compiler.constants.data;
+    program->constantsSize = compiler.constants.size;
+    return opened;
+}
+
+/**
+ * Najdłuższy ciąg poleceń zastępowany instrukcją złożoną.
+ */
+#define FUSION_MAX_LENGTH 3
+
+/**
+ * Ciąg poleceń zastępowany instrukcją złożoną.
+ */
+typedef struct Fusion {
+    uint32_t code; ///< kod instrukcji złożonej
+    size_t length; ///< długość ciągu poleceń
+    uint32_t sequence[FUSION_MAX_LENGTH]; ///< kody kolejnych poleceń
+} Fusion;
+
+/**
+ * Ciągi poleceń zastępowane przez ProgramOptimize, sprawdzane po kolei.
+ */
+static const Fusion FUSIONS[] = {
+    {.code = OP_CLONE_AT_POP, .length = 3, .sequence = {CMD_CLONE, CMD_AT, CMD_POP}},
+    {.code = OP_CLONE_MUL, .length = 2, .sequence = {CMD_CLONE, CMD_MUL}},
+    {.code = OP_NEG_ADD, .length = 2, .sequence = {CMD_NEG, CMD_ADD}},
+    {.code = OP_MUL_ADD, .length = 2, .sequence = {CMD_MUL, CMD_ADD}}
+};
+
+/**
+ * Sprawdza, czy od zadanej instrukcji zaczyna się ciąg poleceń.
+ * @param[in] program : program
+ * @param[in] start : indeks pierwszej instrukcji
+ * @param[in] fusion : ciąg poleceń
+ * @return czy instrukcje programu od @p start to polecenia z ciągu
+ */
+static bool MatchesFusion(const Program* program, size_t start, const Fusion* fusion) {
+    if (program->size - start < fusion->length) {
+        return false;
+    }
+    for (size_t i = 0; i < fusion->length; i++) {
+        if (program->code[start + i].code != fusion->sequence[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProgramOptimize(Program* program) {
+    size_t i = 0;
+    while (i < program->size) {
+        size_t length = 1;
+        for (size_t f = 0; f < sizeof(FUSIONS) / sizeof(FUSIONS[0]); f++) {
+            if (MatchesFusion(program, i, &FUSIONS[f])) {
+                program->code[i].code = FUSIONS[f].code;
+                length = FUSIONS[f].length;
+                break;
+            }
+        }
+        // Zastąpione polecenia zostają w programie na wypadek, gdyby
+        // instrukcja złożona nie mogła zostać wykonana, więc ciągi
+        // nie mogą na siebie zachodzić.
+        i += length;
+    }
+}
+
+/**
+ * Dekoduje stałą z puli i wrzuca ją na stos. Stała, której nie da się
+ * zdekodować, może pochodzić tylko z uszkodzonego pliku pamięci
+ * podręcznej i jest zgłaszana jak błędny wielomian.
+ * @param[in] program : program
+ * @param[in] offset : położenie stałej w puli stałych
+ * @param[in, out] stack : stos
+ * @param[in] lineNumber : numer wiersza skryptu
+ */
+static void PushConstant(const Program* program, uint64_t offset, Stack* stack, int lineNumber) {
+    CacheReader reader = {.pos = program->constants + offset,
+                          .end = program->constants + program->constantsSize};
+    Poly p;
+    if (ReadPoly(&reader, &p)) {
+        Push(stack, p);
+    } else {
+        OutputError(lineNumber, "WRONG POLY");
+    }
+}
+
+void ProgramRun(const Program* program, Stack* stack) {
+    const ProgramOp* end = program->code + program->size;
+    for (const ProgramOp* op = program->code; op < end; op++) {
+        int lineNumber = op->lineNumber;
+        switch (op->code) {
+            case CMD_ADD:
+                ADD(stack, lineNumber);
+                break;
+            case CMD_ZERO:
+                ZERO(stack);
+                break;
+            case CMD_SUB:
+                SUB(stack, lineNumber);
+                break;
+            case CMD_MUL:
+                MUL(stack, lineNumber);
+                break;
+            case CMD_IS_COEFF:
+                IS_COEFF(stack, lineNumber);
+                break;
+            case CMD_IS_ZERO:
+                IS_ZERO(stack, lineNumber);
+                break;
+            case CMD_NEG:
+                NEG(stack, lineNumber);
+                break;
+            case CMD_IS_EQ:
+                IS_EQ(stack, lineNumber);
+                break;
+            case CMD_DEG:
+                DEG(stack, lineNumber);
+                break;
+            case CMD_POP:
+                POP(stack, lineNumber);
+                break;
+            case CMD_PRINT:
+                PRINT(stack, lineNumber);
+                break;
+            case CMD_CLONE:
+                CLONE(stack, lineNumber);
+                break;
+            case CMD_SQR:
+                SQR(stack, lineNumber);
+                break;
+            case CMD_DEG_BY:
+                DEG_BY(stack, op->arg, lineNumber);
+                break;
+            case CMD_AT:
+                AT(stack, (poly_coeff_t) op->arg, lineNumber);
+                break;
+            case CMD_COMPOSE:
+                COMPOSE(stack, lineNumber, op->arg);
+                break;
+            case CMD_AT_MANY:
+                AT_MANY(stack, lineNumber, op->arg);
+                break;
+            case CMD_EVAL:
+                EVAL(stack, lineNumber, op->arg);
+                break;
+            case OP_PUSH:
+                PushConstant(program, op->arg, stack, lineNumber);
+                break;
+            case OP_ERROR:
+                InstructionError((CommandId) op->arg, lineNumber);
+                break;
+            case OP_WRONG_POLY:
+                OutputError(lineNumber, "WRONG POLY");
+                break;
+            // Instrukcja złożona pomija zastąpione polecenia, a jeśli nie
+            // może zostać wykonana, wykonuje pierwsze z nich.
+            case OP_CLONE_MUL:
+                if (CLONE_MUL(stack)) {
+                    op++;
+                } else {
+                    CLONE(stack, lineNumber);
+                }
+                break;
+            case OP_NEG_ADD:
+                if (NEG_ADD(stack)) {
+                    op++;
+                } else {
+                    NEG(stack, lineNumber);
+                }
+                break;
+            case OP_CLONE_AT_POP:
+                // Obliczona wartość od razu jest usuwana, a obliczanie jej
+                // nie ma skutków ubocznych, więc wystarczy niepusty stos.
+                if (!IsStackEmpty(stack)) {
+                    op += 2;
+                } else {
+                    CLONE(stack, lineNumber);
+                }
+                break;
+            case OP_MUL_ADD:
+                if (MUL_ADD(stack)) {
+                    op++;
+                } else {
+                    MUL(stack, lineNumber);
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * Odczytuje wersję skryptu.
+ * @param[in] path : ścieżka do skryptu
+ * @param[out] stamp : wersja skryptu
+ * @return czy udało się odczytać informacje o pliku
+ */
+static bool GetScriptStamp(char const* path, ScriptStamp* stamp) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return false;
+    }
+    memset(stamp, 0, sizeof(*stamp));
+    stamp->size = (uint64_t) info.st_size;
+    stamp->seconds = (int64_t) info.st_mtim.tv_sec;
+    stamp->nanoseconds = (int64_t) info.st_mtim.tv_nsec;
+    return true;
+}
+
+/**
+ * Zapisuje program do pliku pamięci podręcznej. Plik jest najpierw
+ * zapisywany pod nazwą tymczasową, więc przerwany zapis nie zostawia
+ * uszkodzonego pliku. Błąd zapisu nie jest zgłaszany, bo plik pamięci
+ * podręcznej jest tylko przyspieszeniem.
+ * @param[in] program : program
+ * @param[in] path : ścieżka do pliku pamięci podręcznej
+ * @param[in] stamp : wersja skryptu, z którego skompilowano program
+ */
+static void SaveCache(const Program* program, char const* path, const ScriptStamp* stamp) {
+    CacheWriter writer = CacheWriterCreate();
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.byteOrder = CACHE_BYTE_ORDER;
+    header.stamp = *stamp;
+    header.constantsSize = program->constantsSize;
+    header.size = program->size;
+    WriteBytes(&writer, &header, sizeof(header));
+    WriteBytes(&writer, program->constants, program->constantsSize);
+    // Numery wierszy rosną, więc zapisujemy ich różnice.
+    int prevLine = 0;
+    for (size_t i = 0; i < program->size; i++) {
+        const ProgramOp* op = &(program->code[i]);
+        WriteVarint(&writer, op->code);
+        WriteVarint(&writer, (uint64_t) (op->lineNumber - prevLine));
+        WriteVarint(&writer, op->arg);
+        prevLine = op->lineNumber;
+    }
+
+    size_t pathLength = strlen(path);
+    char* tmpPath = malloc(pathLength + sizeof(".tmp"));
+    if (tmpPath == NULL) {
+        exit(1);
+    }
+    memcpy(tmpPath, path, pathLength);
+    memcpy(tmpPath + pathLength, ".tmp", sizeof(".tmp"));
+    FILE* file = fopen(tmpPath, "wb");
+    if (file != NULL) {
+        bool written = fwrite(writer.data, 1, writer.size, file) == writer.size;
+        if (fclose(file) != 0 || !written || rename(tmpPath, path) != 0) {
+            remove(tmpPath);
+        }
+    }
+    free(tmpPath);
+    free(writer.data);
+}
+
+/**
+ * Odczytuje instrukcje programu z pliku pamięci podręcznej, sprawdzając,
+ * czy plik zapisano dla zadanej wersji skryptu i czy instrukcje są
+ * poprawne. Pula stałych nie jest kopiowana: program wskazuje na nią
+ * w danych pliku.
+ * @param[in, out] program : pusty program
+ * @param[in, out] reader : stan odczytu
+ * @param[in] stamp : oczekiwana wersja skryptu
+ * @return czy odczytano program
+ */
+static bool ReadProgram(Program* program, CacheReader* reader, const ScriptStamp* stamp) {
+    CacheHeader header;
+    if (!ReadBytes(reader, &header, sizeof(header)) ||
+        memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byteOrder != CACHE_BYTE_ORDER ||
+        memcmp(&(header.stamp), stamp, sizeof(*stamp)) != 0) {
+        return false;
+    }
+    // Każda instrukcja zajmuje co najmniej trzy bajty.
+    size_t left = (size_t) (reader->end - reader->pos);
+    if (header.constantsSize > left || header.size > (left - header.constantsSize) / 3) {
+        return false;
+    }
+    program->constants = reader->pos;
+    program->constantsSize = header.constantsSize;
+    reader->pos += header.constantsSize;
+
+    uint64_t lineNumber = 0;
+    for (uint64_t i = 0; i < header.size; i++) {
+        uint64_t code, delta, arg;
+        if (!ReadVarint(reader, &code) || !ReadVarint(reader, &delta) ||
+            !ReadVarint(reader, &arg) || delta > INT32_MAX - lineNumber) {
+            return false;
+        }
+        lineNumber += delta;
+        // Instrukcje złożone tworzy dopiero ProgramOptimize, więc nie ma ich
+        // w pliku.
+        bool correct = code < OP_CLONE_MUL && code != CMD_UNKNOWN;
+        if (code == OP_PUSH) {
+            correct = arg < header.constantsSize;
+        } else if (code == OP_ERROR) {
+            correct = arg <= CMD_UNKNOWN;
+        }
+        if (!correct) {
+            return false;
+        }
+        Emit(program, (uint32_t) code, (int) lineNumber, arg);
+    }
+    return reader->pos == reader->end;
+}
+
+/**
+ * Wczytuje program z pliku pamięci podręcznej odwzorowanego w pamięci.
+ * Odwzorowanie pozostaje częścią programu, bo zawiera jego pulę stałych.
+ * @param[out] program : program
+ * @param[in] path : ścieżka do pliku pamięci podręcznej
+ * @param[in] stamp : oczekiwana wersja skryptu
+ * @return czy plik istnieje i zawiera poprawny program dla tej wersji skryptu
+ */
+static bool LoadCache(Program* program, char const* path, const ScriptStamp* stamp) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+        (size_t) info.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = (size_t) info.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    *program = ProgramCreate();
+    program->storage = data;
+    program->mappedSize = size;
+    CacheReader reader = {.pos = data, .end = (const unsigned char*) data + size};
+    if (!ReadProgram(program, &reader, stamp)) {
+        ProgramDestroy(program);
+        return false;
+    }
+    return true;
+}
+
+bool ProgramLoadCached(Program* program, char const* scriptPath, char const* cachePath) {
+    ScriptStamp stamp;
+    if (!GetScriptStamp(scriptPath, &stamp)) {
+        return false;
+    }
+    if (LoadCache(program, cachePath, &stamp)) {
+        return true;
+    }
+    if (!ProgramCompileFile(program, scriptPath)) {
+        ProgramDestroy(program);
+        return false;
+    }
+    SaveCache(program, cachePath, &stamp);
+    return true;
+}
@@ -0,0 +1,104 @@
+/** @file
+ *  Skrypt kalkulatora skompilowany do ciągu instrukcji z pulą stałych
+ *  @author Patrycja Stępień
+*/
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "instruction_scan.h"
+#include "poly.h"
+#include "stack.h"
+
+/**
+ * Kody instrukcji programu. Poprawne polecenia kalkulatora mają kody równe
+ * swoim wartościom CommandId, a pozostałe instrukcje kody większe
+ * od CMD_UNKNOWN. Instrukcje złożone zastępują pierwsze polecenie ciągu
+ * poleceń, które pozostają w programie za nimi. Jeśli stos nie spełnia
+ * warunków instrukcji złożonej, wykonywane jest zastąpione przez nią
+ * polecenie, a po nim kolejne polecenia ciągu.
+ */
+enum ProgramOpCode {
+    OP_PUSH = CMD_UNKNOWN + 1, ///< wrzuć na stos wielomian z puli stałych
+    OP_ERROR, ///< wypisz komunikat o błędnym poleceniu
+    OP_WRONG_POLY, ///< wypisz komunikat o błędnym wielomianie
+    OP_CLONE_MUL, ///< ciąg CLONE MUL, podniesienie do kwadratu
+    OP_NEG_ADD, ///< ciąg NEG ADD, odejmowanie
+    OP_CLONE_AT_POP, ///< ciąg CLONE AT POP, który nie zmienia stosu
+    OP_MUL_ADD ///< ciąg MUL ADD, dodanie iloczynu
+};
+
+/**
+ * Instrukcja programu.
+ */
+typedef struct ProgramOp {
+    uint32_t code; ///< kod instrukcji
+    int32_t lineNumber; ///< numer wiersza skryptu, z którego pochodzi instrukcja
+    /**
+     * Parametr polecenia, dla OP_PUSH położenie stałej w puli stałych,
+     * a dla OP_ERROR polecenie, którego dotyczy błąd.
+     */
+    uint64_t arg;
+} ProgramOp;
+
+/**
+ * Skompilowany skrypt. Wielomiany ze skryptu są sparsowane podczas
+ * kompilacji i trzymane w puli stałych w zwartej postaci binarnej,
+ * dekodowanej dopiero przy wrzucaniu na stos, a polecenia mają
+ * zdekodowane parametry. Wykonanie programu nie czyta już tekstu skryptu.
+ */
+typedef struct Program {
+    ProgramOp* code; ///< instrukcje
+    size_t size; ///< liczba instrukcji
+    size_t capacity; ///< rozmiar tablicy instrukcji
+    const unsigned char* constants; ///< pula stałych
+    size_t constantsSize; ///< rozmiar puli stałych w bajtach
+    void* storage; ///< pamięć zawierająca pulę stałych
+    size_t mappedSize; ///< rozmiar odwzorowanego pliku albo 0, gdy pamięć pochodzi z malloc
+} Program;
+
+/**
+ * Kompiluje skrypt z pliku do programu.
+ * @param[out] program : skompilowany program
+ * @param[in] path : ścieżka do skryptu
+ * @return czy udało się otworzyć skrypt
+ */
+bool ProgramCompileFile(Program* program, char const* path);
+
+/**
+ * Wczytuje program z pliku pamięci podręcznej, jeśli został on zapisany
+ * dla obecnej wersji skryptu. W przeciwnym razie kompiluje skrypt
+ * i zapisuje program do pliku pamięci podręcznej.
+ * @param[out] program : program
+ * @param[in] scriptPath : ścieżka do skryptu
+ * @param[in] cachePath : ścieżka do pliku pamięci podręcznej
+ * @return czy udało się otworzyć skrypt
+ */
+bool ProgramLoadCached(Program* program, char const* scriptPath, char const* cachePath);
+
+/**
+ * Zastępuje w programie częste ciągi poleceń instrukcjami złożonymi,
+ * które nie tworzą na stosie wyników pośrednich. Wykonanie programu daje
+ * te same wyniki i komunikaty o błędach co przed optymalizacją.
+ * @param[in, out] program : program
+ */
+void ProgramOptimize(Program* program);
+
+/**
+ * Wykonuje program na stosie. Program nie jest zmieniany, więc można
+ * go wykonać wielokrotnie.
+ * @param[in] program : program
+ * @param[in, out] stack : stos
+ */
+void ProgramRun(const Program* program, Stack* stack);
+
+/**
+ * Usuwa program z pamięci.
+ * @param[in, out] program : program
+ */
+void ProgramDestroy(Program* program);
+
+#endif /* PROGRAM_H */
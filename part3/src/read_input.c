@@ -4,24 +4,36 @@
 */
 
 /**
- * Makro potrzebne do prawidłowego wykonywania funkcji getline
+ * Makro potrzebne do korzystania z funkcji POSIX: read, mmap i madvise.
  */
 #define _GNU_SOURCE
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "stack.h"
 #include "read_input.h"
 #include "instruction_scan.h"
 #include "poly_execute.h"
+#include "output.h"
 
 /**
  * Początek numerowania wierszy
  */
 #define START_COUNT 1
 
+/**
+ * Początkowa wielkość bufora wejścia i największa porcja danych wczytywana
+ * jednym wywołaniem read. Bufor rośnie tylko dla dłuższych wierszy.
+ */
+#define INPUT_BLOCK_SIZE ((size_t) 1 << 20)
+
 /**
  * Sprawdza, czy znak jest małą lub wielką literą alfabetu angielskiego.
  * @param[in] c : sprawdzany znak
@@ -41,31 +53,164 @@ static bool IsComment(char c) {
 }
 
 /**
- * Ignoruje komentarz
+ * Wykonuje polecenie z wiersza na stosie przekazanym jako kontekst.
+ * @param[in, out] stack : stos
+ * @param[in] line : wiersz z poleceniem
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[in] lineNumber : numer wiersza
+ */
+static void ScanInstruction(void* stack, char const* line, size_t lineSize, int lineNumber) {
+    InstructionScan(stack, line, lineSize, lineNumber);
+}
+
+/**
+ * Wczytuje wielomian z wiersza na stos przekazany jako kontekst.
+ * @param[in, out] stack : stos
+ * @param[in] line : wiersz z wielomianem
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[in] lineNumber : numer wiersza
+ */
+static void ScanPoly(void* stack, char const* line, size_t lineSize, int lineNumber) {
+    PolyScan(stack, line, lineSize, lineNumber);
+}
+
+/**
+ * Obsługa wierszy wykonująca je od razu na stosie.
  */
-static void SkipComment() {
-    int sign = getchar();
-    while (sign != '\n') {
-        sign = getchar();
+static const LineHandlers EXECUTE_HANDLERS = {
+    .instruction = ScanInstruction,
+    .poly = ScanPoly
+};
+
+/**
+ * Przekazuje wiersz z poleceniem lub wielomianem odpowiedniej funkcji
+ * obsługi, pomijając komentarze i puste wiersze.
+ * @param[in] handlers : funkcje obsługi wierszy
+ * @param[in, out] context : kontekst funkcji obsługi
+ * @param[in] line : niepusty wiersz, może nie kończyć się znakiem nowej linii
+ * @param[in] lineSize : długość wiersza razem ze znakiem nowej linii
+ * @param[in] lineNumber : numer wiersza
+ */
+static void ExecuteLine(const LineHandlers* handlers, void* context, char const* line,
+                        size_t lineSize, int lineNumber) {
+    char firstSign = line[0];
+    if (IsComment(firstSign)) {
+    } else if (IsCharLetter(firstSign)) {
+        handlers->instruction(context, line, lineSize, lineNumber);
+    } else if (firstSign == '\n') {
+    } else {
+        handlers->poly(context, line, lineSize, lineNumber);
     }
 }
 
-void ReadInput(Stack* stack) {
-    int firstSign = getchar();
+/**
+ * Wykonuje kolejne pełne wiersze z bufora. Wiersze są przekazywane
+ * parserom bezpośrednio z bufora, bez kopiowania.
+ * @param[in] handlers : funkcje obsługi wierszy
+ * @param[in, out] context : kontekst funkcji obsługi
+ * @param[in] data : bufor
+ * @param[in] size : liczba bajtów w buforze
+ * @param[in] last : czy bufor kończy wejście; wtedy ostatni wiersz
+ *                   nie musi kończyć się znakiem nowej linii
+ * @param[in, out] lineNumber : numer pierwszego wiersza w buforze
+ * @return liczba bajtów zajmowanych przez wykonane wiersze
+ */
+static size_t ExecuteLines(const LineHandlers* handlers, void* context, char const* data,
+                           size_t size, bool last, int* lineNumber) {
+    size_t pos = 0;
+    while (pos < size) {
+        char const* newline = memchr(data + pos, '\n', size - pos);
+        if (newline == NULL && !last) {
+            break;
+        }
+        size_t lineSize = newline != NULL ? (size_t) (newline - data) + 1 - pos : size - pos;
+        ExecuteLine(handlers, context, data + pos, lineSize, *lineNumber);
+        (*lineNumber)++;
+        pos += lineSize;
+    }
+    return pos;
+}
+
+/**
+ * Wczytuje dane z deskryptora porcjami wielkości INPUT_BLOCK_SIZE
+ * i wykonuje żądane polecenia. Niepełny ostatni wiersz porcji jest
+ * przenoszony na początek bufora i dokańczany kolejną porcją.
+ * @param[in] handlers : funkcje obsługi wierszy
+ * @param[in, out] context : kontekst funkcji obsługi
+ * @param[in] fd : deskryptor pliku wejściowego
+ */
+static void ReadInputFd(const LineHandlers* handlers, void* context, int fd) {
+    size_t capacity = INPUT_BLOCK_SIZE;
+    char* buffer = malloc(capacity);
+    if (buffer == NULL) {
+        exit(1);
+    }
+    size_t filled = 0;
     int lineNumber = START_COUNT;
 
-    while (firstSign != EOF) {
-        if (IsComment(firstSign)) {
-            SkipComment();
-        } else if (IsCharLetter(firstSign)) {
-            ungetc(firstSign, stdin);
-            InstructionScan(stack, lineNumber);
-        } else if (firstSign == '\n') {
-        } else {
-            ungetc(firstSign, stdin);
-            PolyScan(stack, lineNumber);
+    while (true) {
+        if (filled == capacity) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+            if (buffer == NULL) {
+                exit(1);
+            }
+        }
+        size_t block = capacity - filled < INPUT_BLOCK_SIZE ? capacity - filled : INPUT_BLOCK_SIZE;
+        // Przed czekaniem na dane oddajemy dotychczasowe wyniki, żeby
+        // kalkulator używany interaktywnie odpowiadał na każde polecenie.
+        OutputFlush();
+        ssize_t readBytes = read(fd, buffer + filled, block);
+        if (readBytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            readBytes = 0;
+        }
+        filled += (size_t) readBytes;
+
+        bool last = readBytes == 0;
+        size_t done = ExecuteLines(handlers, context, buffer, filled, last, &lineNumber);
+        memmove(buffer, buffer + done, filled - done);
+        filled -= done;
+        if (last) {
+            break;
         }
-        firstSign = getchar();
-        lineNumber++;
     }
+    free(buffer);
+}
+
+void ReadInput(Stack* stack) {
+    ReadInputFd(&EXECUTE_HANDLERS, stack, STDIN_FILENO);
+}
+
+bool ReadInputFile(Stack* stack, char const* path) {
+    return ReadFileLines(path, &EXECUTE_HANDLERS, stack);
+}
+
+bool ReadFileLines(char const* path, const LineHandlers* handlers, void* context) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Zwykły plik odwzorowujemy w pamięci i wykonujemy w całości,
+    // pozostałe (np. potoki) czytamy porcjami.
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = (size_t) info.st_size;
+        void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            madvise(data, size, MADV_SEQUENTIAL);
+            int lineNumber = START_COUNT;
+            ExecuteLines(handlers, context, data, size, true, &lineNumber);
+            munmap(data, size);
+            return true;
+        }
+    }
+
+    ReadInputFd(handlers, context, fd);
+    close(fd);
+    return true;
 }
\ No newline at end of file
@@ -5,12 +5,45 @@
 #ifndef READ_INPUT_H
 #define READ_INPUT_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include "stack.h"
 
+/**
+ * Funkcje obsługi kolejnych wierszy wejścia. Wiersz przekazywany jest
+ * razem ze znakiem nowej linii, którego może nie być w ostatnim wierszu.
+ * Komentarze i puste wiersze są pomijane.
+ */
+typedef struct LineHandlers {
+    /** Obsługuje wiersz z poleceniem. */
+    void (*instruction)(void* context, char const* line, size_t lineSize, int lineNumber);
+    /** Obsługuje wiersz z wielomianem. */
+    void (*poly)(void* context, char const* line, size_t lineSize, int lineNumber);
+} LineHandlers;
+
 /**
  * Wczytuje dane ze standardowego wejścia i wykonuje żądane polecenia.
  * @param[in, out] stack : stos
  */
 void ReadInput(Stack* stack);
 
+/**
+ * Wczytuje dane z pliku i wykonuje żądane polecenia. Zwykły plik jest
+ * odwzorowywany w pamięci.
+ * @param[in, out] stack : stos
+ * @param[in] path : ścieżka do pliku
+ * @return czy udało się otworzyć plik
+ */
+bool ReadInputFile(Stack* stack, char const* path);
+
+/**
+ * Wczytuje wiersze z pliku i przekazuje je zadanym funkcjom obsługi.
+ * Zwykły plik jest odwzorowywany w pamięci.
+ * @param[in] path : ścieżka do pliku
+ * @param[in] handlers : funkcje obsługi wierszy
+ * @param[in, out] context : kontekst przekazywany funkcjom obsługi
+ * @return czy udało się otworzyć plik
+ */
+bool ReadFileLines(char const* path, const LineHandlers* handlers, void* context);
+
 #endif /* READ_INPUT_H */
\ No newline at end of file
@@ -8,10 +8,11 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 #include "stack.h"
 #include "poly.h"
+#include "poly_alloc.h"
+#include "output.h"
 
 /**
  * Początkowy rozmiar tworzonych tablic.
@@ -20,10 +21,7 @@
 
 struct Stack StackCreate() {
     Stack stack;
-    stack.arr = malloc(INIT_ARRAY_SIZE * sizeof(Poly));
-    if (stack.arr == NULL) {
-        exit(1);
-    }
+    stack.arr = PolyMalloc(INIT_ARRAY_SIZE * sizeof(Poly));
     stack.curr_size = INIT_ARRAY_SIZE;
     stack.pointer = 0;
 
@@ -36,14 +34,13 @@ struct Stack StackCreate() {
  */
 static void GrowStack(Stack* stack) {
     stack->curr_size = stack->curr_size * 2;
-    stack->arr = realloc(stack->arr, stack->curr_size * sizeof(Poly));
-    if (stack->arr == NULL) {
-        exit(1);
-    }
+    stack->arr = PolyRealloc(stack->arr, stack->curr_size * sizeof(Poly));
 }
 
 /**
  * Zmniejsza dwukrotnie rozmiar tablicy, na której zaimplementowany jest stos.
+ * Po zmniejszeniu tablica jest wypełniona co najwyżej w połowie, więc
+ * kolejne wrzucenia nie powiększają jej od razu z powrotem.
  * @param[in, out] stack : stos
  */
 static void DecreaseStack(Stack* stack) {
@@ -51,17 +48,14 @@ static void DecreaseStack(Stack* stack) {
         return;
     }
     stack->curr_size = stack->curr_size / 2;
-    stack->arr = realloc(stack->arr, stack->curr_size * sizeof(Poly));
-    if (stack->arr == NULL) {
-        exit(1);
-    }
+    stack->arr = PolyRealloc(stack->arr, stack->curr_size * sizeof(Poly));
 }
 
 void StackDestroy(Stack* stack) {
     for (size_t i = 0; i < stack->pointer; i++) {
         PolyDestroy(&(stack->arr[i]));
     }
-    free(stack->arr);
+    PolyFree(stack->arr);
 }
 
 /**
@@ -77,8 +71,15 @@ bool IsStackEmpty(const Stack* stack) {
     return stack->pointer == 0;
 }
 
-bool IsStackHalfEmpty(const Stack* stack) {
-    return stack->pointer <= (stack->curr_size) / 2;
+/**
+ * Sprawdza, czy stos jest wypełniony co najwyżej w jednej czwartej.
+ * Dopiero wtedy zmniejszamy tablicę, żeby naprzemienne wrzucanie
+ * i zdejmowanie na granicy rozmiaru nie przepisywało jej za każdym razem.
+ * @param[in] stack : stos
+ * @return czy stos jest wypełniony co najwyżej w jednej czwartej
+ */
+static bool IsStackQuarterFull(const Stack* stack) {
+    return stack->pointer <= (stack->curr_size) / 4;
 }
 
 bool IsStackSingle(const Stack* stack) {
@@ -89,17 +90,45 @@ bool IsStackOfSizeAtLeastN(const Stack* stack, size_t n) {
     return stack->pointer >= n;
 }
 
+/**
+ * Zmniejsza tablicę stosu, jeśli jest ona w dużej części pusta.
+ * @param[in, out] stack : stos
+ */
+static void ShrinkIfSparse(Stack* stack) {
+    if (IsStackQuarterFull(stack)) {
+        DecreaseStack(stack);
+    }
+}
+
+/**
+ * Zwraca wielomian, który ma trafić na stos, w trybie unikalnych
+ * wielomianów zastępując go jego unikalną kopią.
+ * @param[in] newPoly : wielomian
+ * @return wielomian do zapisania na stosie
+ */
+static Poly Prepare(Poly newPoly) {
+    if (PolyIsInterning()) {
+        return PolyIntern(newPoly);
+    }
+    return newPoly;
+}
+
 void Pop(Stack* stack, int lineNumber) {
     if (IsStackEmpty(stack)) {
-        fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", lineNumber);
+        OutputError(lineNumber, "STACK UNDERFLOW");
         return;
     }
     (stack->pointer)--;
     PolyDestroy(&(stack->arr[stack->pointer]));
+    ShrinkIfSparse(stack);
+}
 
-    if (IsStackHalfEmpty(stack)) {
-        DecreaseStack(stack);
-    }
+Poly Take(Stack* stack) {
+    assert(!IsStackEmpty(stack));
+    (stack->pointer)--;
+    Poly taken = stack->arr[stack->pointer];
+    ShrinkIfSparse(stack);
+    return taken;
 }
 
 Poly* Top(const Stack* stack) {
@@ -110,7 +139,21 @@ void Push(Stack* stack, Poly newPoly) {
     if (IsStackFull(stack)) {
         GrowStack(stack);
     }
-    stack->arr[stack->pointer] = PolyClone(&newPoly);
-    PolyDestroy(&newPoly);
+    stack->arr[stack->pointer] = Prepare(newPoly);
     (stack->pointer)++;
+}
+
+void ReplaceTop(Stack* stack, Poly newPoly) {
+    assert(!IsStackEmpty(stack));
+    Poly* top = Top(stack);
+    PolyDestroy(top);
+    *top = Prepare(newPoly);
+}
+
+void ReplaceTopTwo(Stack* stack, Poly newPoly) {
+    assert(IsStackOfSizeAtLeastN(stack, 2));
+    (stack->pointer)--;
+    PolyDestroy(&(stack->arr[stack->pointer]));
+    ReplaceTop(stack, newPoly);
+    ShrinkIfSparse(stack);
 }
\ No newline at end of file
@@ -37,12 +37,38 @@ void StackDestroy(Stack* stack);
 Poly* Top(const Stack* stack);
 
 /**
- * Wrzuca wielomian na wierzch stosu.
+ * Wrzuca wielomian na wierzch stosu. Stos przejmuje wielomian na własność,
+ * więc wywołujący nie może go już usuwać.
  * @param[in, out] stack : stos
  * @param[in] newPoly : wrzucany wielomian
  */
 void Push(Stack* stack, Poly newPoly);
 
+/**
+ * Zdejmuje wielomian z wierzchołka niepustego stosu i przekazuje go
+ * na własność wywołującemu.
+ * @param[in, out] stack : stos
+ * @return wielomian z wierzchołka stosu
+ */
+Poly Take(Stack* stack);
+
+/**
+ * Zastępuje wielomian z wierzchołka niepustego stosu zadanym wielomianem.
+ * Stary wielomian jest usuwany, a nowy przejmowany na własność.
+ * @param[in, out] stack : stos
+ * @param[in] newPoly : nowy wielomian na wierzchołku
+ */
+void ReplaceTop(Stack* stack, Poly newPoly);
+
+/**
+ * Zastępuje dwa wielomiany z wierzchu stosu jednym, np. wynikiem
+ * działania na nich. Stare wielomiany są usuwane, a nowy przejmowany
+ * na własność. Stos musi zawierać co najmniej dwa wielomiany.
+ * @param[in, out] stack : stos
+ * @param[in] newPoly : nowy wielomian na wierzchołku
+ */
+void ReplaceTopTwo(Stack* stack, Poly newPoly);
+
 /**
  * Usuwa wielomian z wierzchołka stosu.
  * @param[in, out] stack : stos
@@ -57,13 +83,6 @@ void Pop(Stack* stack, int lineNumber);
  */
 bool IsStackEmpty(const Stack* stack);
 
-/**
- * Sprawdza, czy stos jest do połowy pusty.
- * @param[in] stack : stos
- * @return czy stos jest do połowy pusty
- */
-bool IsStackHalfEmpty(const Stack* stack);
-
 /**
  * Sprawdza, czy na stosie znajduje się dokładnie jeden wielomian.
  * @param[in] stack : stos